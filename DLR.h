@@ -11,6 +11,16 @@
 * As Info value may be unrestricted, the Key is unique for every Node of the
 * DLR.
 *
+* The third, optional template parameter is the number of nodes that can be
+* stored inside the DLR object itself. Up to that many nodes are created
+* there instead of on the heap, so small rings don't allocate memory at all.
+*
+* DLR keeps count of its nodes, and optionally a hash of its content, which
+* is updated with every insertion and removal. Rings of different lengths
+* are told apart by operator== without comparing their elements. The hash
+* only serves callers, such as tables of rings, as writes through an
+* Iterator can leave it stale.
+*
 * Also, in the class DLR there's implemented class Iterator. Iterator
 * points to elements (Nodes) of the DLR, with many useful operators
 * to iterate through it. Iterator in this class is implemented as a pointer.
@@ -29,12 +39,136 @@
 #ifndef EADS2_DLR_H
 #define EADS2_DLR_H
 
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <functional>
 #include <new>
 #include <memory>
 #include <iostream>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// hint the CPU to start loading the node that will be visited after the next one
+#if defined(__GNUC__) || defined(__clang__)
+#define DLR_PREFETCH(address) __builtin_prefetch(address)
+#else
+#define DLR_PREFETCH(address) ((void)(address))
+#endif
+
+/***************************************************************************
+*  INLINE SLOTS
+****************************************************************************/
+
+// storage of the nodes kept inside a DLR object, slot i is taken if bit i
+// of slotsUsed is set; DLR derives from it, so that the specialization
+// for no inline nodes, being empty, costs the DLR no space at all
+template<typename Key, typename Info, unsigned int Inline>
+class DLRInlineSlots{
+
+    static_assert(Inline <= 64, "at most 64 nodes can be stored inline");
+
+protected:
+
+    // same layout as DLR::Node, which DLR checks
+    struct Layout{
+        Key key;
+        Info info;
+        void *next;
+        void *previous;
+    };
+
+private:
+
+    typename std::aligned_storage<sizeof(Layout), alignof(Layout)>::type slots[Inline];
+    unsigned long long slotsUsed;
+
+    unsigned int indexOf(const void *node) const{
+        return static_cast<const Layout*>(node) - reinterpret_cast<const Layout*>(slots);
+    }
+
+protected:
+
+    // slots of one DLR are never copied to another
+    DLRInlineSlots(){
+        slotsUsed = 0;
+    }
+
+    DLRInlineSlots(const DLRInlineSlots &){
+        slotsUsed = 0;
+    }
+
+    DLRInlineSlots &operator=(const DLRInlineSlots &){
+        return *this;
+    }
+
+    // RETURNS: memory of a free slot, nullptr if all of them are taken
+    void *freeSlot(){
+        for(unsigned int i = 0; i < Inline; i++){
+            if((slotsUsed & (1ULL << i)) == 0)
+                return &slots[i];
+        }
+        return nullptr;
+    }
+
+    // marks the slot of the node as taken
+    void takeSlot(const void *node){
+        slotsUsed |= 1ULL << indexOf(node);
+    }
+
+    // marks the slot of the node as free
+    void releaseSlot(const void *node){
+        slotsUsed &= ~(1ULL << indexOf(node));
+    }
+
+    // marks every slot as free
+    void releaseSlots(){
+        slotsUsed = 0;
+    }
+
+    // RETURNS: true, if the node is stored in one of the slots
+    bool holdsSlot(const void *node) const{
+        auto first = reinterpret_cast<const Layout*>(slots);
+        auto aNode = static_cast<const Layout*>(node);
+        std::less<const Layout*> before;
+        return !before(aNode, first) && before(aNode, first + Inline);
+    }
+
+};
 
 template<typename Key, typename Info>
-class DLR{
+class DLRInlineSlots<Key, Info, 0>{
+
+protected:
+
+    struct Layout{
+        Key key;
+        Info info;
+        void *next;
+        void *previous;
+    };
+
+    void *freeSlot(){
+        return nullptr;
+    }
+
+    void takeSlot(const void *){}
+
+    void releaseSlot(const void *){}
+
+    void releaseSlots(){}
+
+    bool holdsSlot(const void *) const{
+        return false;
+    }
+
+};
+
+
+template<typename Key, typename Info, unsigned int Inline = 0>
+class DLR: private DLRInlineSlots<Key, Info, Inline>{
 
 private:
 
@@ -58,17 +192,155 @@ private:
         ~Node() = default;
 
         // copy constructor
-        Node(const Key &aKey, const Info &aInfo){
+        Node(const Key &aKey, const Info &aInfo): key(aKey), info(aInfo){
+            next = nullptr;
+            previous = nullptr;
+        }
+
+        // move constructor
+        Node(Key &&aKey, Info &&aInfo): key(std::move(aKey)), info(std::move(aInfo)){
             next = nullptr;
             previous = nullptr;
-            key = aKey;
-            info = aInfo;
         }
 
     };
 
+/***************************************************************************
+*  BLOCK DECLARATION
+****************************************************************************/
+
+    // Contiguous array of nodes made by compact(), preceded by this header.
+    // Nodes may move to other DLRs, so the block counts its nodes in all of
+    // them, and is released together with the last one. A block starts at
+    // a multiple of blockChunk and spans whole chunks of that size. DLRs
+    // sharing a block may be used by different threads, so its count of
+    // nodes is atomic.
+    struct Block{
+        void *memory;           // allocation the block lies in
+        std::atomic<unsigned int> live;
+
+        explicit Block(void *aMemory): memory(aMemory), live(0){}
+    };
+
+    static const unsigned int blockChunk = 4096;
+
+    // Chunk of a block holding some nodes of this DLR. Nodes don't point at
+    // their block, which would cost every node of every DLR a pointer; a DLR
+    // keeps the chunks of its block nodes in a hash map by address instead,
+    // so the block of a node is found in O(1) by rounding its address down
+    // to the chunk. A heap node can't lie in a chunk of a living block.
+    struct BlockShare{
+        Block *block;
+        unsigned int nodes;     // nodes of this DLR starting in the chunk
+    };
+
+    static_assert(sizeof(Node) == sizeof(typename DLRInlineSlots<Key, Info, Inline>::Layout) &&
+                  alignof(Node) == alignof(typename DLRInlineSlots<Key, Info, Inline>::Layout),
+                  "inline slots must fit a Node");
+
     Node *any;
 
+    unsigned int outside;           // nodes of the DLR stored outside the inline slots
+
+    // shares by address of their chunks, nullptr until a node of the DLR
+    // is in a block (a pointer keeps DLRs without blocks small)
+    std::unordered_map<std::uintptr_t, BlockShare> *blocks;
+
+    unsigned int count;             // number of nodes in the DLR
+
+    // Content hash, the sum of hashes of every link of the ring. A link hash
+    // depends on the order of the nodes it joins, so the hash is sensitive
+    // to order, yet an insertion or removal changes only two links.
+    std::size_t (*hasher)(const Key&, const Info&);   // nullptr if hashing is disabled
+    std::size_t contentHash;
+
+    double compactThreshold;        // fragmentation ratio triggering compact(), 0 if disabled
+    unsigned int mutations;         // modifications since the last fragmentation check
+    unsigned int compactInterval;   // modifications between fragmentation checks
+
+    Node *createNode(const Key &newKey, const Info &newInfo);
+    // creates a single node in a free inline slot, or on the heap
+    // THROWS:
+    //    std::bad_alloc in case of memory allocation failure
+
+    void destroyNode(Node *node);
+    // destroys a node, freeing its inline slot, or releasing its block
+    // if it was the last one in there
+
+    bool isInline(const Node *node) const;
+    // RETURNS:
+    //    true, if the node is stored in an inline slot of this DLR
+
+    static Block *newBlock(unsigned int size);
+    // allocates a block for given number of nodes, without creating them
+    // THROWS:
+    //    std::bad_alloc in case of memory allocation failure
+
+    static Node *nodesOf(Block *block);
+    // RETURNS:
+    //    first node of the block
+
+    static void freeBlock(Block *block);
+    // releases a block, its nodes must have been destroyed
+
+    static std::uintptr_t chunkOf(const Node *node);
+    // RETURNS:
+    //    address of the chunk the node starts in
+
+    BlockShare *findShare(const Node *node);
+    // RETURNS:
+    //    share of the chunk holding the node, nullptr for a heap node
+
+    BlockShare &shareOf(Block *block, const Node *node);
+    // RETURNS:
+    //    share of the chunk holding the node, added with no nodes if missing;
+    //    the caller must count the node in it
+    // THROWS:
+    //    std::bad_alloc in case of memory allocation failure, nothing is added then
+
+    void addShares(Block *block, unsigned int size);
+    // counts all nodes of a new block as nodes of this DLR
+    // THROWS:
+    //    std::bad_alloc in case of memory allocation failure, nothing is counted then
+
+    void dropShares(Block *block, unsigned int size);
+    // forgets all chunks of a block, undoing addShares()
+
+    void dropShare(const Node *node, BlockShare *share);
+    // stops counting a single node of the block as a node of this DLR
+
+    std::size_t linkHash(const Node *from, const Node *to) const;
+    // RETURNS:
+    //    hash of the link going from one node to the other
+
+    void linked(Node *node);
+    // accounts for a node which has just been linked into the ring
+
+    void unlinking(Node *node);
+    // accounts for a node which is about to be unlinked from the ring
+
+    void noteMutation();
+    // counts a modification and compacts the DLR if automatic compaction
+    // is enabled and the measured fragmentation exceeds the threshold
+
+    void linkBack(Node *node);
+    // links a detached node at the end of the DLR
+
+    void linkBefore(Node *position, Node *node);
+    // links a detached node before the given node of a non empty DLR
+
+    void unlink(Node *node);
+    // detaches a node from the DLR without destroying it
+
+    Node *take(DLR<Key, Info, Inline> &from, Node *node);
+    // detaches a node from another DLR, handing its ownership over to this one;
+    // a node stored inline in the other DLR is replaced by a copy
+    // RETURNS:
+    //    detached node owned by this DLR
+    // THROWS:
+    //    std::bad_alloc in case of memory allocation failure, the node is
+    //    left in the other DLR then
+
 
 public:
 
@@ -119,7 +391,7 @@ public:
      *  ITERATOR MOVEMENT OPERATORS
      *****************************************************/
 
-        Iterator &operator++() const{
+        const Iterator &operator++() const{
             travel = travel -> next;
             return *this;
         }
@@ -130,7 +402,7 @@ public:
             return temp;
         }
 
-        Iterator &operator--() const{
+        const Iterator &operator--() const{
             travel = travel -> previous;
             return *this;
         }
@@ -229,21 +501,39 @@ public:
     // default constructor
         DLR(){
             any = nullptr;
+            outside = 0;
+            blocks = nullptr;
+            count = 0;
+            hasher = nullptr;
+            contentHash = 0;
+            compactThreshold = 0;
+            mutations = 0;
+            compactInterval = 0;
         }
 
     // default destructor
         ~DLR(){
-            clear();
+            if(any != nullptr)
+                clear();
+            delete blocks;
         }
 
     // copy constructor
-        DLR(const DLR<Key, Info> &aDLR){
+        DLR(const DLR<Key, Info, Inline> &aDLR): DLRInlineSlots<Key, Info, Inline>(){
             any = nullptr;
+            outside = 0;
+            blocks = nullptr;
+            count = 0;
+            hasher = nullptr;
+            contentHash = 0;
+            compactThreshold = 0;
+            mutations = 0;
+            compactInterval = 0;
             *this = aDLR;
         }
 
     // assignment operator
-        DLR<Key, Info> &operator=(const DLR<Key, Info> &aDLR);
+        DLR<Key, Info, Inline> &operator=(const DLR<Key, Info, Inline> &aDLR);
 
 
 
@@ -270,7 +560,43 @@ public:
 
     unsigned int length() const;
     // RETURNS:
-    //    number of nodes in the DLR
+    //    number of nodes in the DLR, in constant time
+
+    double fragmentation() const;
+    // RETURNS:
+    //    ratio (0 to 1) of links jumping backwards in memory, or further
+    //    forward than a page; 0 for a freshly compacted DLR, and close to 0
+    //    for one freshly filled with pushBack
+
+
+    /***************************************************************************
+    *  CONTENT HASH
+    ****************************************************************************/
+
+        void enableHash(std::size_t (*aHasher)(const Key&, const Info&) = &defaultHash);
+        // starts maintaining the content hash, computing it for the current
+        // content; call it again after modifying a Key or Info through an
+        // Iterator, as the hash can't notice that
+        // PARAMETERS: function hashing a single Key and Info pair,
+        //             defaultly std::hash of both combined
+
+        void disableHash();
+        // stops maintaining the content hash
+
+        std::size_t hash() const;
+        // RETURNS:
+        //    content hash, which is equal for equal DLRs hashed with the
+        //    same function, unless one was modified through an Iterator since
+        //    enableHash(); 0 if hashing is disabled
+
+        static std::size_t defaultHash(const Key &key, const Info &info);
+        // RETURNS:
+        //    std::hash of the Key and Info combined
+
+        static std::size_t mix(std::size_t value);
+        // RETURNS:
+        //    value with its bits scrambled, so that hashes differing only
+        //    in a few bits spread over the whole range
 
 
     /***************************************************************************
@@ -294,6 +620,18 @@ public:
         // THROWS:
         //    std::bad_alloc in case of memory allocation failure
 
+        void pushBack(const std::vector<std::pair<Key, Info>> &elements);
+        // inserts new elements at the end of the DLR, in the given order;
+        // free inline slots are filled first, the nodes of the remaining
+        // elements are created in a single contiguous allocation (block),
+        // or one by one if they are too few to fill a page
+        // PARAMETERS: Key and Info pairs of new nodes
+        // THROWS:
+        //    std::bad_alloc in case of memory allocation failure,
+        //    the DLR is left unchanged then
+        // !A BLOCK IS FREED ONLY WITH THE LAST OF ITS NODES, SO A FEW SURVIVING NODES KEEP
+        //  THE WHOLE BLOCK ALLOCATED; compact() OR AUTOMATIC COMPACTION RELEASES SUCH BLOCKS!
+
         bool insertAfter(const Key &key, const Key &newKey, const Info &newInfo, int occurrence = 1);
         // inserts a new element after the given one
         // PARAMETERS: Key and Info of new node,
@@ -346,32 +684,134 @@ public:
          *  methods of removing from the DLR
         ************************************************************************/
 
-        void remove(const Key &key, int occurrence = 1);
+        bool remove(const Key &key, int occurrence = 1);
         // removes given element from the DLR
         // PARAMETERS: Key of the node to remove,
         //             number of node's occurrence, defaultly 1
+        // RETURNS:
+        //    true, if the element has been removed
+        //    false, if there's no such element
 
-        void remove(const Iterator &location);
+        bool remove(const Iterator &location);
         // removes the element from the DLR at which given iterator points at
         // PARAMETERS: an Iterator
+        // RETURNS:
+        //    true, if the element has been removed
+        //    false, if the iterator doesn't point at any element
 
         void clear();
         // removes every element from the DLR
 
 
+        /***********************************************************************
+         *  memory layout
+        ************************************************************************/
+
+        void compact();
+        // relocates the nodes stored outside the inline slots into a single
+        // contiguous allocation, in ring order starting from 'any', so
+        // traversals walk memory sequentially; inline nodes stay in their
+        // slots, does nothing if all the nodes are stored inline
+        // !INVALIDATES ALL ITERATORS!
+        // THROWS:
+        //    std::bad_alloc in case of memory allocation failure,
+        //    the DLR is left unchanged then
+
+        void setAutoCompact(double threshold);
+        // enables automatic compaction: every so many modifications the
+        // fragmentation is measured, and compact() is called when it exceeds
+        // the threshold
+        // PARAMETERS: fragmentation ratio (0 to 1), 0 disables auto compaction
+        // !WHEN ENABLED, ANY MODIFIER MAY INVALIDATE ALL ITERATORS!
+
+
+        /***********************************************************************
+         *  algorithms
+         *  Nodes are relinked, never copied nor allocated, and iterators keep
+         *  pointing at the same elements. The only exception are nodes stored
+         *  inline in the other DLR, which are copied when they move over.
+         *  A node of a block moving to another DLR may need an entry for its
+         *  chunk there, which allocates memory once per chunk; heap nodes
+         *  never allocate. Algorithms reordering a DLR recompute its content
+         *  hash, if enabled.
+         *  If copying an inline node or allocating a chunk entry throws, the
+         *  exception is passed on: the elements moved so far stay moved, the
+         *  rest stay where they were, and both DLRs are valid, with no
+         *  element lost nor duplicated (basic guarantee).
+        ************************************************************************/
+
+        template<typename Predicate>
+        void partition(Predicate predicate, DLR<Key, Info, Inline> &rejected);
+        // moves the elements not satisfying the predicate to the end of
+        // another DLR, keeping the order of elements in both
+        // PARAMETERS: callable taking (const Key&, const Info&), returning
+        //             true for the elements to keep,
+        //             DLR receiving the other elements
+        // THROWS:
+        //    see the algorithms note above
+
+        void split(const Iterator &at, DLR<Key, Info, Inline> &tail);
+        // moves the elements from the given one up to the end of the DLR
+        // to the end of another DLR, keeping their order
+        // PARAMETERS: an Iterator pointing at the first element to move,
+        //             DLR receiving the elements
+        // THROWS:
+        //    see the algorithms note above
+
+        template<typename Compare>
+        void mergeSorted(DLR<Key, Info, Inline> &other, Compare compare);
+        // moves all elements of another DLR into this one, both sorted by
+        // key, so that the result is sorted too; of equal keys, the elements
+        // of this DLR come first
+        // PARAMETERS: DLR to empty,
+        //             callable taking (const Key&, const Key&), returning
+        //             true if the first key goes before the second one
+        // THROWS:
+        //    see the algorithms note above
+
+        void mergeSorted(DLR<Key, Info, Inline> &other);
+        // mergeSorted ordering keys with operator<
+
+        void interleave(DLR<Key, Info, Inline> &other);
+        // moves all elements of another DLR into this one, so that they
+        // alternate: this first, other first, this second, other second...;
+        // the remaining elements of the longer DLR stay at the end
+        // PARAMETERS: DLR to empty
+        // THROWS:
+        //    see the algorithms note above
+
+        void reverse();
+        // reverses the order of elements, 'any' is the last element then
+
+        void rotate(int moveBy);
+        // moves 'any' forward by given number of elements, backward if negative
+        // PARAMETERS: number of elements
+
+        template<typename Compare>
+        void sort(Compare compare);
+        // sorts the elements by key, keeping the order of equal keys; natural
+        // merge sort, so already sorted runs of elements are merged right away
+        // PARAMETERS: callable taking (const Key&, const Key&), returning
+        //             true if the first key goes before the second one
+
+        void sort();
+        // sort ordering keys with operator<
+
+
     /***************************************************************************
     *  OPERATORS
     ****************************************************************************/
 
-        bool operator==(const DLR<Key, Info> &aDLR) const;
-        // compares two DLRs
+        bool operator==(const DLR<Key, Info, Inline> &aDLR) const;
+        // compares two DLRs, DLRs of different lengths are rejected in constant
+        // time; content hashes aren't trusted, as they may be stale
         // PARAMETERS: constant reference to another DLR
         // RETURNS:
         //      true if the DLRs are identical (order matters)
         //      false, if the DLRs are different
         // !ORDER MATTERS!
 
-        bool operator!=(const DLR<Key, Info> &aDLR) const;
+        bool operator!=(const DLR<Key, Info, Inline> &aDLR) const;
         // compares two DLRs
         // PARAMETERS: constant reference to another DLR
         // RETURNS:
@@ -388,8 +828,8 @@ public:
 ************************************************************************/
 
 
-template<typename Key, typename Info>
-typename DLR<Key, Info>::Iterator DLR<Key, Info>::find(const Key &aKey, int occurrence) const {
+template<typename Key, typename Info, unsigned int Inline>
+typename DLR<Key, Info, Inline>::Iterator DLR<Key, Info, Inline>::find(const Key &aKey, int occurrence) const {
 
     if(any == nullptr)
         return Iterator();
@@ -398,6 +838,7 @@ typename DLR<Key, Info>::Iterator DLR<Key, Info>::find(const Key &aKey, int occu
     auto travel = any;
     do{
 
+        DLR_PREFETCH(travel -> next -> next);
         if(travel -> key == aKey && ++i == occurrence)
             return Iterator(travel);
         travel = travel -> next;
@@ -412,13 +853,16 @@ typename DLR<Key, Info>::Iterator DLR<Key, Info>::find(const Key &aKey, int occu
 //--------------------------------------------------------------------------
 
 
-template<typename Key, typename Info>
-DLR<Key, Info> &DLR<Key, Info>::operator=(const DLR<Key, Info> &aDLR) {
+template<typename Key, typename Info, unsigned int Inline>
+DLR<Key, Info, Inline> &DLR<Key, Info, Inline>::operator=(const DLR<Key, Info, Inline> &aDLR) {
 
     if(this == &aDLR)
         return *this;
 
-    clear();
+    if(any != nullptr)
+        clear();
+
+    hasher = aDLR.hasher;
 
     if(aDLR.any == nullptr)
         return *this;
@@ -436,8 +880,8 @@ DLR<Key, Info> &DLR<Key, Info>::operator=(const DLR<Key, Info> &aDLR) {
 //--------------------------------------------------------------------------
 
 
-template<typename Key, typename Info>
-bool DLR<Key, Info>::exists(const Key &key) {
+template<typename Key, typename Info, unsigned int Inline>
+bool DLR<Key, Info, Inline>::exists(const Key &key) {
 
 
     //empty DLR
@@ -447,6 +891,7 @@ bool DLR<Key, Info>::exists(const Key &key) {
     //non empty DLR
     auto travel = this->any;
     do{
+        DLR_PREFETCH(travel -> next -> next);
         if(travel -> key == key)
             return true;
         travel = travel -> next;
@@ -461,8 +906,8 @@ bool DLR<Key, Info>::exists(const Key &key) {
 //--------------------------------------------------------------------------
 
 
-template<typename Key, typename Info>
-unsigned int DLR<Key, Info>::howMany(const Key &aKey) {
+template<typename Key, typename Info, unsigned int Inline>
+unsigned int DLR<Key, Info, Inline>::howMany(const Key &aKey) {
 
     //empty DLR
     if(this -> any == nullptr)
@@ -472,6 +917,7 @@ unsigned int DLR<Key, Info>::howMany(const Key &aKey) {
      unsigned int count = 0;
      auto travel = this->any;
     do{
+        DLR_PREFETCH(travel -> next -> next);
         if(travel -> key == aKey)
             count++;
         travel = travel->next;
@@ -486,8 +932,8 @@ unsigned int DLR<Key, Info>::howMany(const Key &aKey) {
 //--------------------------------------------------------------------------
 
 
-template<typename Key, typename Info>
-bool DLR<Key, Info>::isEmpty() {
+template<typename Key, typename Info, unsigned int Inline>
+bool DLR<Key, Info, Inline>::isEmpty() {
 
     return any == nullptr;
 
@@ -498,31 +944,49 @@ bool DLR<Key, Info>::isEmpty() {
 
 
 
-template<typename Key, typename Info>
-unsigned int DLR<Key, Info>::length() const {
+template<typename Key, typename Info, unsigned int Inline>
+unsigned int DLR<Key, Info, Inline>::length() const {
 
-    //empty DLR
-    if(this -> any == nullptr)
+    return count;
+}
+
+
+//--------------------------------------------------------------------------
+
+
+template<typename Key, typename Info, unsigned int Inline>
+double DLR<Key, Info, Inline>::fragmentation() const {
+
+    //empty or 1 elem DLR
+    if(this -> any == nullptr || any -> next == any)
         return 0;
 
-    //non empty DLR
-    unsigned int count = 0;
+    //non empty DLR, the link closing the ring is not taken into account;
+    //short jumps forward are what hardware prefetchers follow well
+    const std::uintptr_t page = 4096;
+    unsigned int links = 0;
+    unsigned int scattered = 0;
     auto travel = this->any;
     do{
-        count++;
+        DLR_PREFETCH(travel -> next -> next);
+        links++;
+        auto from = reinterpret_cast<std::uintptr_t>(travel);
+        auto to = reinterpret_cast<std::uintptr_t>(travel -> next);
+        if(to <= from || to - from > page)
+            scattered++;
         travel = travel->next;
 
-    }while(travel != any);
+    }while(travel -> next != any);
 
-    return count;
+    return static_cast<double>(scattered) / links;
 }
 
 
 //--------------------------------------------------------------------------
 
 
-template<typename Key, typename Info>
-void DLR<Key, Info>::print() {
+template<typename Key, typename Info, unsigned int Inline>
+void DLR<Key, Info, Inline>::print() {
 
     //empty DLR
     if(this -> any == nullptr) {
@@ -544,16 +1008,18 @@ void DLR<Key, Info>::print() {
 //--------------------------------------------------------------------------
 
 
-template<typename Key, typename Info>
-void DLR<Key, Info>::pushBack(const Key &newKey, const Info &newInfo) {
+template<typename Key, typename Info, unsigned int Inline>
+void DLR<Key, Info, Inline>::pushBack(const Key &newKey, const Info &newInfo) {
 
-    auto newNode = new Node(newKey, newInfo);
+    auto newNode = createNode(newKey, newInfo);
 
     //empty DLR
     if(this -> any == nullptr){
         any = newNode;
         any->next = any;
         any->previous = any;
+        linked(any);
+        noteMutation();
         return;
     }
 
@@ -564,6 +1030,9 @@ void DLR<Key, Info>::pushBack(const Key &newKey, const Info &newInfo) {
     any->previous->next = newNode;
     any->previous = newNode;
 
+    linked(newNode);
+    noteMutation();
+
 }
 
 
@@ -572,8 +1041,90 @@ void DLR<Key, Info>::pushBack(const Key &newKey, const Info &newInfo) {
 //--------------------------------------------------------------------------
 
 
-template<typename Key, typename Info>
-bool DLR<Key, Info>::insertAfter(const Key &key, const Key &newKey, const Info &newInfo, int occurrence) {
+template<typename Key, typename Info, unsigned int Inline>
+void DLR<Key, Info, Inline>::pushBack(const std::vector<std::pair<Key, Info>> &elements) {
+
+    if(elements.empty())
+        return;
+
+    //fewer elements than fit in a chunk would get a chunk of their own
+    //in a block, so they are created one by one instead
+    const std::size_t blockMinimum = std::max<std::size_t>(blockChunk / sizeof(Node), 2);
+
+    //the DLR is left untouched until every node is created; nodes created
+    //one by one are chained through their next pointers until then
+    Node *firstSingle = nullptr;
+    Node *lastSingle = nullptr;
+    unsigned int single = 0;
+    Block *block = nullptr;
+    unsigned int built = 0;
+
+    try{
+        //free inline slots, and the heap for a short rest
+        for(; single < elements.size(); single++){
+            if(elements.size() - single >= blockMinimum && this -> freeSlot() == nullptr)
+                break;
+
+            auto newNode = createNode(elements[single].first, elements[single].second);
+            newNode -> next = nullptr;
+            if(lastSingle == nullptr)
+                firstSingle = newNode;
+            else
+                lastSingle -> next = newNode;
+            lastSingle = newNode;
+        }
+
+        //new block for the rest
+        if(single < elements.size()){
+            block = newBlock(elements.size() - single);
+            addShares(block, elements.size() - single);
+
+            for(unsigned int i = single; i < elements.size(); i++){
+                new (nodesOf(block) + built) Node(elements[i].first, elements[i].second);
+                built++;
+            }
+        }
+    }
+    catch(...){
+        if(block != nullptr){
+            for(unsigned int i = 0; i < built; i++)
+                nodesOf(block)[i].~Node();
+            dropShares(block, elements.size() - single);
+            freeBlock(block);
+        }
+        while(firstSingle != nullptr){
+            auto next = firstSingle -> next;
+            destroyNode(firstSingle);
+            firstSingle = next;
+        }
+        throw;
+    }
+
+    //link the new nodes one after another at the end of the DLR
+    while(firstSingle != nullptr){
+        auto next = firstSingle -> next;
+        linkBack(firstSingle);
+        firstSingle = next;
+    }
+
+    if(block != nullptr){
+        for(unsigned int i = 0; i < built; i++)
+            linkBack(nodesOf(block) + i);
+        block -> live = built;
+        outside += built;
+    }
+
+    for(unsigned int i = 0; i < elements.size(); i++)
+        noteMutation();
+
+}
+
+
+//--------------------------------------------------------------------------
+
+
+template<typename Key, typename Info, unsigned int Inline>
+bool DLR<Key, Info, Inline>::insertAfter(const Key &key, const Key &newKey, const Info &newInfo, int occurrence) {
 
     if(any == nullptr){
         std::cerr << "DLR is empty." << std::endl;
@@ -592,7 +1143,7 @@ bool DLR<Key, Info>::insertAfter(const Key &key, const Key &newKey, const Info &
     }
 
     auto iterator = find(key, occurrence);
-    return insertAfter(newKey, newInfo, iterator);
+    return insertAfter(iterator, newKey, newInfo);
 
 
 
@@ -602,20 +1153,22 @@ bool DLR<Key, Info>::insertAfter(const Key &key, const Key &newKey, const Info &
 //--------------------------------------------------------------------------
 
 
-template<typename Key, typename Info>
-bool DLR<Key, Info>::insertAfter(const DLR::Iterator &location, const Key &newKey, const Info &newInfo) {
+template<typename Key, typename Info, unsigned int Inline>
+bool DLR<Key, Info, Inline>::insertAfter(const DLR::Iterator &location, const Key &newKey, const Info &newInfo) {
 
 
     if(location.travel == nullptr) {
         return false;
     }
 
-    auto insert = new Node( newKey, newInfo );
+    auto insert = createNode( newKey, newInfo );
     insert -> previous = location.travel;
     insert -> next = location.travel -> next;
     location.travel -> next -> previous = insert;
     location.travel -> next = insert;
 
+    linked(insert);
+    noteMutation();
 
     return true;
 
@@ -625,8 +1178,8 @@ bool DLR<Key, Info>::insertAfter(const DLR::Iterator &location, const Key &newKe
 //--------------------------------------------------------------------------
 
 
-template<typename Key, typename Info>
-bool DLR<Key, Info>::insertBefore(const Key &key, const Key &newKey, const Info &newInfo, int occurrence) {
+template<typename Key, typename Info, unsigned int Inline>
+bool DLR<Key, Info, Inline>::insertBefore(const Key &key, const Key &newKey, const Info &newInfo, int occurrence) {
 
     if(any == nullptr){
         std::cerr << "DLR is empty." << std::endl;
@@ -645,7 +1198,7 @@ bool DLR<Key, Info>::insertBefore(const Key &key, const Key &newKey, const Info
     }
 
     auto iterator = find(key, occurrence);
-    return insertBefore(newKey, newInfo, iterator);
+    return insertBefore(iterator, newKey, newInfo);
 
 }
 
@@ -653,18 +1206,20 @@ bool DLR<Key, Info>::insertBefore(const Key &key, const Key &newKey, const Info
 //--------------------------------------------------------------------------
 
 
-template<typename Key, typename Info>
-bool DLR<Key, Info>::insertBefore(const DLR::Iterator &location, const Key &newKey, const Info &newInfo) {
+template<typename Key, typename Info, unsigned int Inline>
+bool DLR<Key, Info, Inline>::insertBefore(const DLR::Iterator &location, const Key &newKey, const Info &newInfo) {
 
     if(location.travel == nullptr)
         return false;
 
-    auto insert = new Node(newKey, newInfo);
+    auto insert = createNode(newKey, newInfo);
     insert -> next = location.travel;
     insert -> previous = location.travel -> previous;
     location.travel -> previous -> next = insert;
     location.travel -> previous = insert;
 
+    linked(insert);
+    noteMutation();
 
     return true;
 }
@@ -673,28 +1228,28 @@ bool DLR<Key, Info>::insertBefore(const DLR::Iterator &location, const Key &newK
 //--------------------------------------------------------------------------
 
 
-template<typename Key, typename Info>
-void DLR<Key, Info>::remove(const Key &key, int occurrence) {
+template<typename Key, typename Info, unsigned int Inline>
+bool DLR<Key, Info, Inline>::remove(const Key &key, int occurrence) {
 
     //empty DLR
     if(any == nullptr){
         std::cerr << "DLR is empty." << std::endl;
-        return;
+        return false;
     }
 
     if(howMany(key) == 0) {
         std::cerr << "Given key '" << key << "' doesn't exist in the DLR." << std::endl;
-        return;
+        return false;
     }
 
     if(howMany(key) < occurrence){
         std::cerr << "Given occurrence index exceeds number of given keys" << std::endl;
         std::cerr << "Key: " << key << ", found: " << howMany(key) << " times. Given occurrences: " << occurrence << " ." << std::endl;
-        return;
+        return false;
     }
 
     auto iterator = find(key, occurrence);
-    remove(iterator);
+    return remove(iterator);
 
 
 }
@@ -703,27 +1258,33 @@ void DLR<Key, Info>::remove(const Key &key, int occurrence) {
 //--------------------------------------------------------------------------
 
 
-template<typename Key, typename Info>
-void DLR<Key, Info>::remove(const DLR::Iterator &location) {
+template<typename Key, typename Info, unsigned int Inline>
+bool DLR<Key, Info, Inline>::remove(const DLR::Iterator &location) {
 
 
     //empty DLR
     if(location.travel == nullptr){
-        return;
+        return false;
     }
 
+    unlinking(location.travel);
+
     //1 elem DLR
     if(any == any->next){
-        delete any;
+        destroyNode(any);
         any = nullptr;
-        return;
+        return true;
     }
 
     //more than 1 elem DLR
     location.travel -> next -> previous = location.travel -> previous;
     location.travel -> previous -> next = location.travel -> next;
     any = location.travel -> next;
-    delete location.travel;
+    destroyNode(location.travel);
+
+    noteMutation();
+
+    return true;
 
 }
 
@@ -733,8 +1294,8 @@ void DLR<Key, Info>::remove(const DLR::Iterator &location) {
 //--------------------------------------------------------------------------
 
 
-template<typename Key, typename Info>
-void DLR<Key, Info>::clear() {
+template<typename Key, typename Info, unsigned int Inline>
+void DLR<Key, Info, Inline>::clear() {
 
     //empty DLR
     if(any == nullptr){
@@ -742,17 +1303,30 @@ void DLR<Key, Info>::clear() {
         return;
     }
 
+    //only inline nodes, which need no destructor
+    if(outside == 0 && std::is_trivially_destructible<Node>::value){
+        any = nullptr;
+        this -> releaseSlots();
+        count = 0;
+        contentHash = 0;
+        mutations = 0;
+        return;
+    }
+
     auto travel = any -> next;
-    do{
+    while(travel != any){
 
         auto temp = travel;
         travel = travel -> next;
-        delete temp;
+        destroyNode(temp);
 
-    }while(travel != any);
+    }
 
-    delete any;
+    destroyNode(any);
     any = nullptr;
+    count = 0;
+    contentHash = 0;
+    mutations = 0;
 
 
 
@@ -762,33 +1336,80 @@ void DLR<Key, Info>::clear() {
 //--------------------------------------------------------------------------
 
 
-template<typename Key, typename Info>
-bool DLR<Key, Info>::operator==(const DLR<Key, Info> &aDLR) const {
-
-    //different lengths
-    if(this->length() != aDLR.length())
-        return false;
+template<typename Key, typename Info, unsigned int Inline>
+void DLR<Key, Info, Inline>::compact() {
 
-    //same lengths and one of them empty, so both empty
-    if(this -> any == nullptr)
-        return true;
+    //empty DLR, or every node already next to each other in the inline slots
+    if(any == nullptr || outside == 0)
+        return;
 
-     auto travel1 = any;
-     auto travel2 = aDLR.any;
 
-     //non empty DLR
-     do{
+    //new block for the nodes outside the inline slots, everything that can
+    //fail is done before the old nodes change
+    auto relocated = outside;
+    auto block = newBlock(relocated);
+    auto nodes = nodesOf(block);
+    try{
+        addShares(block, relocated);
+    }
+    catch(...){
+        freeBlock(block);
+        throw;
+    }
 
-         if(travel1 -> key != travel2 -> key ||
-            travel2 -> info != travel2 ->info)
-             return false;
+    //contents are moved, unless moving could throw and leave the DLR broken
+    unsigned int built = 0;
+    auto travel = any;
+    try{
+        do{
+            DLR_PREFETCH(travel -> next -> next);
+            if(!isInline(travel)){
+                new (nodes + built) Node(std::move_if_noexcept(travel -> key),
+                                         std::move_if_noexcept(travel -> info));
+                built++;
+            }
+            travel = travel -> next;
 
-         travel1 = travel1 -> next;
-         travel2 = travel2 -> next;
+        }while(travel != any);
+    }
+    catch(...){
+        for(unsigned int i = 0; i < built; i++)
+            nodes[i].~Node();
+        dropShares(block, relocated);
+        freeBlock(block);
+        throw;
+    }
+    block -> live = relocated;
+
+    //the new nodes take the places of the old ones in the ring, the inline
+    //nodes stay where they are
+    built = 0;
+    travel = any;
+    for(unsigned int i = 0; i < count; i++){
+        auto node = travel;
+        travel = travel -> next;
+        if(isInline(node))
+            continue;
 
-     }while(travel1 != any && travel2 != aDLR.any);
+        auto copy = nodes + built++;
+        if(node -> next == node){
+            copy -> next = copy;
+            copy -> previous = copy;
+        }
+        else{
+            copy -> next = node -> next;
+            copy -> previous = node -> previous;
+            node -> previous -> next = copy;
+            node -> next -> previous = copy;
+        }
+        if(any == node)
+            any = copy;
+        destroyNode(node);
+    }
 
-    return true;
+    outside = relocated;
+    mutations = 0;
+    compactInterval = count;
 
 }
 
@@ -796,8 +1417,789 @@ bool DLR<Key, Info>::operator==(const DLR<Key, Info> &aDLR) const {
 //--------------------------------------------------------------------------
 
 
-template<typename Key, typename Info>
-bool DLR<Key, Info>::operator!=(const DLR<Key, Info> &aDLR) const {
+template<typename Key, typename Info, unsigned int Inline>
+template<typename Predicate>
+void DLR<Key, Info, Inline>::partition(Predicate predicate, DLR<Key, Info, Inline> &rejected) {
+
+    if(&rejected == this)
+        return;
+
+    unsigned int remaining = count;
+    auto travel = any;
+    while(remaining-- > 0){
+        auto node = travel;
+        travel = travel -> next;
+
+        if(!predicate(static_cast<const Key&>(node -> key), static_cast<const Info&>(node -> info)))
+            rejected.linkBack(rejected.take(*this, node));
+    }
+
+}
+
+
+//--------------------------------------------------------------------------
+
+
+template<typename Key, typename Info, unsigned int Inline>
+void DLR<Key, Info, Inline>::split(const Iterator &at, DLR<Key, Info, Inline> &tail) {
+
+    if(at.travel == nullptr || &tail == this)
+        return;
+
+    //number of elements from the given one to the end
+    unsigned int moved = 1;
+    for(auto travel = at.travel; travel -> next != any; travel = travel -> next)
+        moved++;
+
+    auto travel = at.travel;
+    while(moved-- > 0){
+        auto node = travel;
+        travel = travel -> next;
+        tail.linkBack(tail.take(*this, node));
+    }
+
+}
+
+
+//--------------------------------------------------------------------------
+
+
+template<typename Key, typename Info, unsigned int Inline>
+template<typename Compare>
+void DLR<Key, Info, Inline>::mergeSorted(DLR<Key, Info, Inline> &other, Compare compare) {
+
+    if(&other == this)
+        return;
+
+    //elements of this DLR not passed yet
+    unsigned int remaining = count;
+    auto travel = any;
+
+    while(other.any != nullptr){
+        auto node = other.any;
+        while(remaining > 0 && !compare(node -> key, travel -> key)){
+            DLR_PREFETCH(travel -> next -> next);
+            travel = travel -> next;
+            remaining--;
+        }
+
+        node = take(other, node);
+        if(remaining == 0){
+            linkBack(node);
+            continue;
+        }
+
+        linkBefore(travel, node);
+        if(travel == any)
+            any = node;
+    }
+
+}
+
+
+//--------------------------------------------------------------------------
+
+
+template<typename Key, typename Info, unsigned int Inline>
+void DLR<Key, Info, Inline>::mergeSorted(DLR<Key, Info, Inline> &other) {
+
+    mergeSorted(other, std::less<Key>());
+
+}
+
+
+//--------------------------------------------------------------------------
+
+
+template<typename Key, typename Info, unsigned int Inline>
+void DLR<Key, Info, Inline>::interleave(DLR<Key, Info, Inline> &other) {
+
+    if(&other == this)
+        return;
+
+    //elements of this DLR not passed yet
+    unsigned int remaining = count;
+    auto travel = any;
+
+    while(other.any != nullptr){
+        auto node = take(other, other.any);
+        if(remaining == 0){
+            linkBack(node);
+            continue;
+        }
+
+        linkBefore(travel -> next, node);
+        travel = node -> next;
+        remaining--;
+    }
+
+}
+
+
+//--------------------------------------------------------------------------
+
+
+template<typename Key, typename Info, unsigned int Inline>
+void DLR<Key, Info, Inline>::reverse() {
+
+    //empty DLR
+    if(any == nullptr)
+        return;
+
+    auto travel = any;
+    do{
+        DLR_PREFETCH(travel -> next -> next);
+        std::swap(travel -> next, travel -> previous);
+        travel = travel -> previous;
+
+    }while(travel != any);
+
+    //the former last element
+    any = any -> next;
+
+    if(hasher != nullptr)
+        enableHash(hasher);
+
+}
+
+
+//--------------------------------------------------------------------------
+
+
+template<typename Key, typename Info, unsigned int Inline>
+void DLR<Key, Info, Inline>::rotate(int moveBy) {
+
+    //empty DLR
+    if(any == nullptr)
+        return;
+
+    //the shorter way round
+    int steps = moveBy % static_cast<int>(count);
+    if(steps < 0)
+        steps += count;
+
+    if(static_cast<unsigned int>(steps) <= count / 2){
+        for(int i = 0; i < steps; i++)
+            any = any -> next;
+    }
+    else{
+        for(unsigned int i = steps; i < count; i++)
+            any = any -> previous;
+    }
+
+}
+
+
+//--------------------------------------------------------------------------
+
+
+template<typename Key, typename Info, unsigned int Inline>
+template<typename Compare>
+void DLR<Key, Info, Inline>::sort(Compare compare) {
+
+    //empty or 1 elem DLR
+    if(any == nullptr || any -> next == any)
+        return;
+
+    //sorted as a null terminated list linked by 'next' only
+    Node *head = any;
+    any -> previous -> next = nullptr;
+
+    unsigned int runs;
+    do{
+        runs = 0;
+        Node *sorted = nullptr;
+        Node **tail = &sorted;
+        Node *rest = head;
+
+        while(rest != nullptr){
+            runs++;
+
+            //first run
+            Node *first = rest;
+            Node *firstEnd = first;
+            while(firstEnd -> next != nullptr && !compare(firstEnd -> next -> key, firstEnd -> key))
+                firstEnd = firstEnd -> next;
+
+            Node *second = firstEnd -> next;
+            if(second == nullptr){
+                *tail = first;
+                break;
+            }
+
+            //second run
+            Node *secondEnd = second;
+            while(secondEnd -> next != nullptr && !compare(secondEnd -> next -> key, secondEnd -> key))
+                secondEnd = secondEnd -> next;
+
+            rest = secondEnd -> next;
+            firstEnd -> next = nullptr;
+            secondEnd -> next = nullptr;
+
+            //merge, on equal keys the first run goes first
+            while(first != nullptr && second != nullptr){
+                if(compare(second -> key, first -> key)){
+                    *tail = second;
+                    second = second -> next;
+                }
+                else{
+                    *tail = first;
+                    first = first -> next;
+                }
+                tail = &(*tail) -> next;
+            }
+
+            if(first != nullptr){
+                *tail = first;
+                tail = &firstEnd -> next;
+            }
+            else{
+                *tail = second;
+                tail = &secondEnd -> next;
+            }
+        }
+
+        head = sorted;
+
+    }while(runs > 1);
+
+    //restore the links backwards and close the ring
+    Node *previous = head;
+    Node *travel = head -> next;
+    while(travel != nullptr){
+        travel -> previous = previous;
+        previous = travel;
+        travel = travel -> next;
+    }
+    previous -> next = head;
+    head -> previous = previous;
+    any = head;
+
+    if(hasher != nullptr)
+        enableHash(hasher);
+
+}
+
+
+//--------------------------------------------------------------------------
+
+
+template<typename Key, typename Info, unsigned int Inline>
+void DLR<Key, Info, Inline>::sort() {
+
+    sort(std::less<Key>());
+
+}
+
+
+//--------------------------------------------------------------------------
+
+
+template<typename Key, typename Info, unsigned int Inline>
+void DLR<Key, Info, Inline>::setAutoCompact(double threshold) {
+
+    compactThreshold = threshold;
+    mutations = 0;
+    compactInterval = length();
+
+}
+
+
+//--------------------------------------------------------------------------
+
+
+template<typename Key, typename Info, unsigned int Inline>
+typename DLR<Key, Info, Inline>::Node *DLR<Key, Info, Inline>::createNode(const Key &newKey, const Info &newInfo) {
+
+    //free inline slot
+    auto slot = this -> freeSlot();
+    if(slot != nullptr){
+        auto node = new (slot) Node(newKey, newInfo);
+        this -> takeSlot(node);
+        return node;
+    }
+
+    auto node = new Node(newKey, newInfo);
+    outside++;
+    return node;
+
+}
+
+
+//--------------------------------------------------------------------------
+
+
+template<typename Key, typename Info, unsigned int Inline>
+void DLR<Key, Info, Inline>::destroyNode(Node *node) {
+
+    //inline node
+    if(isInline(node)){
+        this -> releaseSlot(node);
+        node -> ~Node();
+        return;
+    }
+
+    outside--;
+
+    //heap node
+    auto share = findShare(node);
+    if(share == nullptr){
+        delete node;
+        return;
+    }
+
+    //node inside a block, the block goes away with its last node, which
+    //may be destroyed by any of the DLRs sharing it
+    auto block = share -> block;
+    dropShare(node, share);
+    node -> ~Node();
+    if(block -> live.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        freeBlock(block);
+
+}
+
+
+//--------------------------------------------------------------------------
+
+
+template<typename Key, typename Info, unsigned int Inline>
+bool DLR<Key, Info, Inline>::isInline(const Node *node) const {
+
+    return this -> holdsSlot(node);
+
+}
+
+
+//--------------------------------------------------------------------------
+
+
+template<typename Key, typename Info, unsigned int Inline>
+typename DLR<Key, Info, Inline>::Block *DLR<Key, Info, Inline>::newBlock(unsigned int size) {
+
+    //the header and the nodes, rounded up to whole chunks
+    std::size_t header = (sizeof(Block) + alignof(Node) - 1) / alignof(Node) * alignof(Node);
+    std::size_t bytes = (header + size * sizeof(Node) + blockChunk - 1) / blockChunk * blockChunk;
+
+    //room to start the block at a multiple of blockChunk
+    auto memory = ::operator new(bytes + blockChunk);
+    auto start = (reinterpret_cast<std::uintptr_t>(memory) + blockChunk - 1) & ~std::uintptr_t(blockChunk - 1);
+
+    return new (reinterpret_cast<void*>(start)) Block(memory);
+
+}
+
+
+//--------------------------------------------------------------------------
+
+
+template<typename Key, typename Info, unsigned int Inline>
+typename DLR<Key, Info, Inline>::Node *DLR<Key, Info, Inline>::nodesOf(Block *block) {
+
+    std::size_t header = (sizeof(Block) + alignof(Node) - 1) / alignof(Node) * alignof(Node);
+    return reinterpret_cast<Node*>(reinterpret_cast<char*>(block) + header);
+
+}
+
+
+//--------------------------------------------------------------------------
+
+
+template<typename Key, typename Info, unsigned int Inline>
+void DLR<Key, Info, Inline>::freeBlock(Block *block) {
+
+    auto memory = block -> memory;
+    block -> ~Block();
+    ::operator delete(memory);
+
+}
+
+
+//--------------------------------------------------------------------------
+
+
+template<typename Key, typename Info, unsigned int Inline>
+std::uintptr_t DLR<Key, Info, Inline>::chunkOf(const Node *node) {
+
+    return reinterpret_cast<std::uintptr_t>(node) & ~std::uintptr_t(blockChunk - 1);
+
+}
+
+
+//--------------------------------------------------------------------------
+
+
+template<typename Key, typename Info, unsigned int Inline>
+typename DLR<Key, Info, Inline>::BlockShare *DLR<Key, Info, Inline>::findShare(const Node *node) {
+
+    if(blocks == nullptr || blocks -> empty())
+        return nullptr;
+
+    auto found = blocks -> find(chunkOf(node));
+    if(found == blocks -> end())
+        return nullptr;
+
+    return &found -> second;
+
+}
+
+
+//--------------------------------------------------------------------------
+
+
+template<typename Key, typename Info, unsigned int Inline>
+typename DLR<Key, Info, Inline>::BlockShare &DLR<Key, Info, Inline>::shareOf(Block *block, const Node *node) {
+
+    if(blocks == nullptr)
+        blocks = new std::unordered_map<std::uintptr_t, BlockShare>();
+
+    return blocks -> emplace(chunkOf(node), BlockShare{block, 0}).first -> second;
+
+}
+
+
+//--------------------------------------------------------------------------
+
+
+template<typename Key, typename Info, unsigned int Inline>
+void DLR<Key, Info, Inline>::addShares(Block *block, unsigned int size) {
+
+    auto nodes = nodesOf(block);
+    try{
+        //nodes follow each other, so each chunk is looked up once
+        BlockShare *share = nullptr;
+        std::uintptr_t chunk = 0;
+        for(unsigned int i = 0; i < size; i++){
+            if(share == nullptr || chunkOf(nodes + i) != chunk){
+                chunk = chunkOf(nodes + i);
+                share = &shareOf(block, nodes + i);
+            }
+            share -> nodes++;
+        }
+    }
+    catch(...){
+        dropShares(block, size);
+        throw;
+    }
+
+}
+
+
+//--------------------------------------------------------------------------
+
+
+template<typename Key, typename Info, unsigned int Inline>
+void DLR<Key, Info, Inline>::dropShares(Block *block, unsigned int size) {
+
+    if(blocks == nullptr || size == 0)
+        return;
+
+    auto nodes = nodesOf(block);
+    for(auto chunk = chunkOf(nodes); chunk <= chunkOf(nodes + size - 1); chunk += blockChunk)
+        blocks -> erase(chunk);
+
+}
+
+
+//--------------------------------------------------------------------------
+
+
+template<typename Key, typename Info, unsigned int Inline>
+void DLR<Key, Info, Inline>::dropShare(const Node *node, BlockShare *share) {
+
+    //a chunk is forgotten as soon as it holds no node of this DLR, as its
+    //block may be released by another DLR and the memory reused
+    if(--share -> nodes == 0)
+        blocks -> erase(chunkOf(node));
+
+}
+
+
+//--------------------------------------------------------------------------
+
+
+template<typename Key, typename Info, unsigned int Inline>
+void DLR<Key, Info, Inline>::noteMutation() {
+
+    if(compactThreshold <= 0)
+        return;
+
+    //checks are spread so that measuring costs O(1) per modification
+    const unsigned int minInterval = 64;
+    if(++mutations < compactInterval || mutations < minInterval)
+        return;
+
+    mutations = 0;
+    if(fragmentation() > compactThreshold)
+        compact();
+    else
+        compactInterval = length();
+
+}
+
+
+//--------------------------------------------------------------------------
+
+
+template<typename Key, typename Info, unsigned int Inline>
+void DLR<Key, Info, Inline>::enableHash(std::size_t (*aHasher)(const Key&, const Info&)) {
+
+    hasher = aHasher;
+    contentHash = 0;
+
+    //empty DLR
+    if(any == nullptr)
+        return;
+
+    auto travel = any;
+    do{
+        DLR_PREFETCH(travel -> next -> next);
+        contentHash += linkHash(travel, travel -> next);
+        travel = travel -> next;
+
+    }while(travel != any);
+
+}
+
+
+//--------------------------------------------------------------------------
+
+
+template<typename Key, typename Info, unsigned int Inline>
+void DLR<Key, Info, Inline>::disableHash() {
+
+    hasher = nullptr;
+    contentHash = 0;
+
+}
+
+
+//--------------------------------------------------------------------------
+
+
+template<typename Key, typename Info, unsigned int Inline>
+std::size_t DLR<Key, Info, Inline>::hash() const {
+
+    return contentHash;
+
+}
+
+
+//--------------------------------------------------------------------------
+
+
+template<typename Key, typename Info, unsigned int Inline>
+std::size_t DLR<Key, Info, Inline>::defaultHash(const Key &key, const Info &info) {
+
+    return mix(std::hash<Key>()(key)) ^ std::hash<Info>()(info);
+
+}
+
+
+//--------------------------------------------------------------------------
+
+
+template<typename Key, typename Info, unsigned int Inline>
+std::size_t DLR<Key, Info, Inline>::mix(std::size_t value) {
+
+    //finalizer of splitmix64
+    unsigned long long x = value;
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebULL;
+    x ^= x >> 31;
+    return static_cast<std::size_t>(x);
+
+}
+
+
+//--------------------------------------------------------------------------
+
+
+template<typename Key, typename Info, unsigned int Inline>
+std::size_t DLR<Key, Info, Inline>::linkHash(const Node *from, const Node *to) const {
+
+    //asymmetric, so a link backwards hashes differently
+    return mix(hasher(from -> key, from -> info) * 0x9e3779b97f4a7c15ULL + hasher(to -> key, to -> info));
+
+}
+
+
+//--------------------------------------------------------------------------
+
+
+template<typename Key, typename Info, unsigned int Inline>
+void DLR<Key, Info, Inline>::linked(Node *node) {
+
+    count++;
+
+    if(hasher == nullptr)
+        return;
+
+    //first node of the ring, linked to itself
+    if(node -> next == node){
+        contentHash += linkHash(node, node);
+        return;
+    }
+
+    //the link between the neighbours is replaced by two links through the node
+    contentHash -= linkHash(node -> previous, node -> next);
+    contentHash += linkHash(node -> previous, node) + linkHash(node, node -> next);
+
+}
+
+
+//--------------------------------------------------------------------------
+
+
+template<typename Key, typename Info, unsigned int Inline>
+void DLR<Key, Info, Inline>::unlinking(Node *node) {
+
+    count--;
+
+    if(hasher == nullptr)
+        return;
+
+    //last node of the ring, linked to itself
+    if(node -> next == node){
+        contentHash -= linkHash(node, node);
+        return;
+    }
+
+    //two links through the node are replaced by the link between the neighbours
+    contentHash -= linkHash(node -> previous, node) + linkHash(node, node -> next);
+    contentHash += linkHash(node -> previous, node -> next);
+
+}
+
+
+//--------------------------------------------------------------------------
+
+
+template<typename Key, typename Info, unsigned int Inline>
+void DLR<Key, Info, Inline>::linkBack(Node *node) {
+
+    //empty DLR
+    if(any == nullptr){
+        any = node;
+        any -> next = any;
+        any -> previous = any;
+        linked(any);
+        return;
+    }
+
+    linkBefore(any, node);
+
+}
+
+
+//--------------------------------------------------------------------------
+
+
+template<typename Key, typename Info, unsigned int Inline>
+void DLR<Key, Info, Inline>::linkBefore(Node *position, Node *node) {
+
+    node -> next = position;
+    node -> previous = position -> previous;
+    position -> previous -> next = node;
+    position -> previous = node;
+    linked(node);
+
+}
+
+
+//--------------------------------------------------------------------------
+
+
+template<typename Key, typename Info, unsigned int Inline>
+void DLR<Key, Info, Inline>::unlink(Node *node) {
+
+    unlinking(node);
+
+    //1 elem DLR
+    if(node -> next == node){
+        any = nullptr;
+        return;
+    }
+
+    node -> next -> previous = node -> previous;
+    node -> previous -> next = node -> next;
+    if(any == node)
+        any = node -> next;
+
+}
+
+
+//--------------------------------------------------------------------------
+
+
+template<typename Key, typename Info, unsigned int Inline>
+typename DLR<Key, Info, Inline>::Node *DLR<Key, Info, Inline>::take(DLR<Key, Info, Inline> &from, Node *node) {
+
+    //inline node, copied before it's detached
+    if(from.isInline(node)){
+        auto copy = createNode(node -> key, node -> info);
+        from.unlink(node);
+        from.destroyNode(node);
+        return copy;
+    }
+
+    //node inside a block, this DLR becomes one of the block owners
+    auto share = from.findShare(node);
+    if(share != nullptr){
+        shareOf(share -> block, node).nodes++;
+        from.dropShare(node, share);
+    }
+
+    from.unlink(node);
+    from.outside--;
+    outside++;
+    return node;
+
+}
+
+
+//--------------------------------------------------------------------------
+
+
+template<typename Key, typename Info, unsigned int Inline>
+bool DLR<Key, Info, Inline>::operator==(const DLR<Key, Info, Inline> &aDLR) const {
+
+    //different lengths
+    if(this->length() != aDLR.length())
+        return false;
+
+    //same lengths and one of them empty, so both empty
+    if(this -> any == nullptr)
+        return true;
+
+     auto travel1 = any;
+     auto travel2 = aDLR.any;
+
+     //non empty DLR
+     do{
+
+         DLR_PREFETCH(travel1 -> next -> next);
+         DLR_PREFETCH(travel2 -> next -> next);
+         if(travel1 -> key != travel2 -> key ||
+            travel1 -> info != travel2 -> info)
+             return false;
+
+         travel1 = travel1 -> next;
+         travel2 = travel2 -> next;
+
+     }while(travel1 != any && travel2 != aDLR.any);
+
+    return true;
+
+}
+
+
+//--------------------------------------------------------------------------
+
+
+template<typename Key, typename Info, unsigned int Inline>
+bool DLR<Key, Info, Inline>::operator!=(const DLR<Key, Info, Inline> &aDLR) const {
 
     return !(*this == aDLR);
 
@@ -0,0 +1,387 @@
+//
+// Created by Ernest Pokropek
+//
+
+
+/***************************************************************************
+* MutationQueue lets many threads modify a shared DLR without each of them
+* locking it for every single modification. A thread records modifications
+* into its own Batch, which needs no locking, and submits the whole batch
+* at once. A single applier takes all the submitted batches together and
+* applies them under one lock of the DLR, in the order of submission.
+*
+* Consecutive pushBacks, also across batches, are applied together, so
+* their nodes are created in one contiguous allocation (see
+* DLR::pushBack), unless they are too few to fill a page, when they are
+* created one by one. Such an allocation stays until all of its nodes are
+* removed, so a DLR with many removals should have automatic compaction
+* enabled (DLR::setAutoCompact) to release it earlier. Every submitted
+* batch gets a future, which becomes ready once all of its modifications
+* are applied, and tells which of them found their element. The applier
+* never reports anything itself, in particular it doesn't print.
+*
+* Anybody else accessing the DLR must hold the lock returned by mutex(),
+* or use read().
+*
+* Nomenclature:
+ * batch -> sequence of modifications recorded by one thread
+ * applier -> thread calling apply() or run(), there should be only one
+****************************************************************************/
+
+#ifndef EADS2_MUTATIONQUEUE_H
+#define EADS2_MUTATIONQUEUE_H
+
+#include <condition_variable>
+#include <exception>
+#include <future>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include "DLR.h"
+
+template<typename Key, typename Info, unsigned int Inline = 0>
+class MutationQueue{
+
+private:
+
+/***************************************************************************
+*  OPERATION DECLARATION
+****************************************************************************/
+
+    struct Operation{
+        enum Type{ PushBack, InsertAfter, InsertBefore, Remove };
+
+        Type type;
+        Key key;        // key of the node the operation refers to
+        Key newKey;
+        Info newInfo;
+        int occurrence;
+    };
+
+    struct Submitted{
+        std::vector<Operation> operations;
+        std::promise<std::vector<bool>> done;
+    };
+
+    DLR<Key, Info, Inline> &ring;
+    std::mutex ringLock;
+
+    std::vector<Submitted> pending;
+    std::mutex pendingLock;
+    std::condition_variable wake;
+    bool stopping;
+
+
+public:
+
+/***************************************************************************
+*  BATCH
+****************************************************************************/
+
+    class Batch{
+    private:
+        friend class MutationQueue;
+        std::vector<Operation> operations;
+
+    public:
+
+    /****************************************************
+    *  BATCH METHODS
+    *****************************************************/
+
+        // records DLR::pushBack(newKey, newInfo)
+        void pushBack(const Key &newKey, const Info &newInfo){
+            operations.push_back(Operation{Operation::PushBack, Key(), newKey, newInfo, 0});
+        }
+
+        // records DLR::insertAfter(key, newKey, newInfo, occurrence)
+        void insertAfter(const Key &key, const Key &newKey, const Info &newInfo, int occurrence = 1){
+            operations.push_back(Operation{Operation::InsertAfter, key, newKey, newInfo, occurrence});
+        }
+
+        // records DLR::insertBefore(key, newKey, newInfo, occurrence)
+        void insertBefore(const Key &key, const Key &newKey, const Info &newInfo, int occurrence = 1){
+            operations.push_back(Operation{Operation::InsertBefore, key, newKey, newInfo, occurrence});
+        }
+
+        // records DLR::remove(key, occurrence)
+        void remove(const Key &key, int occurrence = 1){
+            operations.push_back(Operation{Operation::Remove, key, Key(), Info(), occurrence});
+        }
+
+        // RETURNS:
+        //    number of recorded modifications
+        unsigned int size() const{
+            return operations.size();
+        }
+
+    };
+
+
+/***************************************************************************
+*  MUTATIONQUEUE METHODS
+****************************************************************************/
+
+    /****************************************************
+    *  MEMBER METHODS
+    *****************************************************/
+
+    // constructor
+    // PARAMETERS: DLR modified by the queue, it must outlive the queue
+        explicit MutationQueue(DLR<Key, Info, Inline> &aRing): ring(aRing){
+            stopping = false;
+        }
+
+    // default destructor
+        ~MutationQueue() = default;
+
+    // the queue is shared by reference between threads
+        MutationQueue(const MutationQueue &) = delete;
+        MutationQueue &operator=(const MutationQueue &) = delete;
+
+
+    /***************************************************************************
+    *  SUBMITTING
+    ****************************************************************************/
+
+    std::future<std::vector<bool>> submit(Batch &batch);
+    // hands the recorded modifications over to the applier, leaving the
+    // batch empty and ready for recording again
+    // PARAMETERS: batch of modifications
+    // RETURNS:
+    //    future, ready once the modifications are applied; it holds one
+    //    result per modification, in the order of recording:
+    //       true, if the modification has been applied
+    //       false, if the element it refers to doesn't exist
+    //    (pushBacks are always applied); it holds the exception instead
+    //    if one of them threw, the ones after it aren't applied then
+
+
+    /***************************************************************************
+    *  APPLYING
+    ****************************************************************************/
+
+    unsigned int apply();
+    // applies all the batches submitted so far, under a single lock of the DLR
+    // RETURNS:
+    //    number of applied batches
+
+    void run();
+    // applies submitted batches as they come, until stop() is called;
+    // meant to be the body of the applier thread
+
+    void stop();
+    // makes run() return once all the batches submitted before are applied
+
+
+    /***************************************************************************
+    *  ACCESS
+    ****************************************************************************/
+
+    std::mutex &mutex();
+    // RETURNS:
+    //    lock guarding the DLR against the applier
+
+    template<typename Function>
+    void read(Function function);
+    // calls function(ring) with the DLR locked
+    // PARAMETERS: callable taking (DLR<Key, Info, Inline>&)
+
+};
+
+
+/***********************************************************************
+*   IMPLEMENTATION
+************************************************************************/
+
+
+template<typename Key, typename Info, unsigned int Inline>
+std::future<std::vector<bool>> MutationQueue<Key, Info, Inline>::submit(Batch &batch) {
+
+    Submitted submitted;
+    submitted.operations.swap(batch.operations);
+    auto future = submitted.done.get_future();
+
+    {
+        std::lock_guard<std::mutex> guard(pendingLock);
+        pending.push_back(std::move(submitted));
+    }
+    wake.notify_one();
+
+    return future;
+
+}
+
+
+//--------------------------------------------------------------------------
+
+
+template<typename Key, typename Info, unsigned int Inline>
+unsigned int MutationQueue<Key, Info, Inline>::apply() {
+
+    std::vector<Submitted> batches;
+    {
+        std::lock_guard<std::mutex> guard(pendingLock);
+        batches.swap(pending);
+    }
+
+    if(batches.empty())
+        return 0;
+
+    std::vector<std::exception_ptr> failures(batches.size());
+    std::vector<std::vector<bool>> results(batches.size());
+    {
+        std::lock_guard<std::mutex> guard(ringLock);
+
+        //pushBacks are gathered until another kind of operation comes,
+        //a batch isn't done before its gathered pushBacks are applied, and
+        //fails if they can't be
+        std::vector<std::pair<Key, Info>> pushed;
+        std::vector<unsigned int> pushers;      // batches with pushBacks gathered
+        pushers.reserve(batches.size());
+
+        auto flush = [&](){
+            if(pushed.empty())
+                return;
+            try{
+                ring.pushBack(pushed);
+            }
+            catch(...){
+                for(auto pusher : pushers){
+                    if(failures[pusher] == nullptr)
+                        failures[pusher] = std::current_exception();
+                }
+            }
+            pushed.clear();
+            pushers.clear();
+        };
+
+        for(unsigned int i = 0; i < batches.size(); i++){
+            results[i].reserve(batches[i].operations.size());
+            for(auto &operation : batches[i].operations){
+                if(operation.type == Operation::PushBack){
+                    try{
+                        pushed.push_back(std::make_pair(operation.newKey, operation.newInfo));
+                    }
+                    catch(...){
+                        failures[i] = std::current_exception();
+                        break;
+                    }
+                    if(pushers.empty() || pushers.back() != i)
+                        pushers.push_back(i);
+                    results[i].push_back(true);
+                    continue;
+                }
+
+                //only a batch whose own pushBacks were lost stops here
+                flush();
+                if(failures[i] != nullptr)
+                    break;
+
+                //the element is looked up here, as the keyed DLR methods
+                //report a missing one on std::cerr
+                try{
+                    auto location = ring.find(operation.key, operation.occurrence);
+                    bool applied = false;
+                    switch(operation.type){
+                        case Operation::InsertAfter:
+                            applied = ring.insertAfter(location, operation.newKey, operation.newInfo);
+                            break;
+                        case Operation::InsertBefore:
+                            applied = ring.insertBefore(location, operation.newKey, operation.newInfo);
+                            break;
+                        case Operation::Remove:
+                            applied = ring.remove(location);
+                            break;
+                        case Operation::PushBack:
+                            break;
+                    }
+                    results[i].push_back(applied);
+                }
+                catch(...){
+                    failures[i] = std::current_exception();
+                    break;
+                }
+            }
+        }
+
+        flush();
+    }
+
+    //results are handed out with the DLR unlocked
+    for(unsigned int i = 0; i < batches.size(); i++){
+        if(failures[i] != nullptr)
+            batches[i].done.set_exception(failures[i]);
+        else
+            batches[i].done.set_value(std::move(results[i]));
+    }
+
+    return batches.size();
+
+}
+
+
+//--------------------------------------------------------------------------
+
+
+template<typename Key, typename Info, unsigned int Inline>
+void MutationQueue<Key, Info, Inline>::run() {
+
+    std::unique_lock<std::mutex> guard(pendingLock);
+    while(true){
+        wake.wait(guard, [this]{ return stopping || !pending.empty(); });
+
+        if(pending.empty()){
+            stopping = false;
+            return;
+        }
+
+        guard.unlock();
+        apply();
+        guard.lock();
+    }
+
+}
+
+
+//--------------------------------------------------------------------------
+
+
+template<typename Key, typename Info, unsigned int Inline>
+void MutationQueue<Key, Info, Inline>::stop() {
+
+    {
+        std::lock_guard<std::mutex> guard(pendingLock);
+        stopping = true;
+    }
+    wake.notify_all();
+
+}
+
+
+//--------------------------------------------------------------------------
+
+
+template<typename Key, typename Info, unsigned int Inline>
+std::mutex &MutationQueue<Key, Info, Inline>::mutex() {
+
+    return ringLock;
+
+}
+
+
+//--------------------------------------------------------------------------
+
+
+template<typename Key, typename Info, unsigned int Inline>
+template<typename Function>
+void MutationQueue<Key, Info, Inline>::read(Function function) {
+
+    std::lock_guard<std::mutex> guard(ringLock);
+    function(ring);
+
+}
+
+
+#endif //EADS2_MUTATIONQUEUE_H
@@ -0,0 +1,594 @@
+//
+// Created by Ernest Pokropek
+//
+
+
+/***************************************************************************
+* RoundRobin is a thread-safe scheduler over the elements of a DLR. Any
+* number of threads may call next() at the same time to get the element
+* whose turn it is, while other threads mark elements as down or up,
+* or reload the members after the DLR has been modified.
+*
+* The elements are picked with smooth weighted round-robin: in a round,
+* a member of weight w gets w turns, spread evenly over the round, at
+* about round / w turns from each other, and members of the same weight
+* take their turns apart. An element of weight 3 is thus
+* picked three times as often as an element of weight 1, and never three
+* times in a row while the other one waits. Weights are taken from the
+* Info of every element.
+*
+* reload() builds a schedule holding the turns of the whole round, and
+* publishes it at once. next() takes a ticket from an atomic counter and
+* reads the member of that turn, in constant time, without traversing the
+* DLR nor waiting for a writer. Members of the same key share a health
+* flag in the schedule; markDown() and markUp() flip the flag in constant
+* time, and next() moves on to the following turn when the flag is down.
+*
+* A round takes memory linear in the sum of the weights, divided by their
+* greatest common divisor. Above 64 turns per member (and at least 4096),
+* the weights are scaled down to that length, rounding each one, but to
+* no less than 1 turn.
+*
+* A replaced schedule is freed once no next() can be reading it. Readers
+* announce themselves in one of several counters, picked per thread, so
+* that dispatching threads don't all write the same cache line.
+*
+* Nomenclature:
+ * member -> copy of a single element of the DLR taken by reload()
+ * round -> sequence of turns after which the schedule repeats
+ * turn -> position in the round, naming the member picked there
+ * down -> a member which is skipped by next() until it's marked up again
+ * writer -> reload(), markDown() or markUp(), they run one at a time
+****************************************************************************/
+
+#ifndef EADS2_ROUNDROBIN_H
+#define EADS2_ROUNDROBIN_H
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "DLR.h"
+
+template<typename Key, typename Info, typename Hash = std::hash<Key>>
+class RoundRobin{
+
+private:
+
+/***************************************************************************
+*  SCHEDULE DECLARATION
+****************************************************************************/
+
+    struct Member{
+        Key key;
+        Info info;
+        unsigned int state;     // health flag of its key
+    };
+
+    // Immutable once published, except for the health flags.
+    struct Schedule{
+        std::vector<Member> members;                        // in order of the DLR
+        std::vector<unsigned int> turns;                    // member picked at each turn of the round
+        std::unordered_map<Key, unsigned int, Hash> states; // health flag of every key
+        std::unique_ptr<std::atomic<bool>[]> down;          // health flags
+        std::vector<bool> weighted;                         // whether members of the key have turns
+        std::atomic<unsigned int> upWeighted;               // keys up, whose members have turns
+    };
+
+    static const unsigned int turnsPerMember = 64;
+    static const unsigned int minTurns = 4096;
+
+/***************************************************************************
+*  READERS DECLARATION
+****************************************************************************/
+
+    // Count of next() calls reading a schedule, per epoch. Writers flip the
+    // epoch, so new readers count themselves in the other counter, and wait
+    // for the old counter to drop to 0. The padding keeps counters of
+    // different slots off the same cache line; alignas wouldn't do, as
+    // it isn't honoured for heap instances before C++17.
+    struct Readers{
+        char padding[64];
+        std::atomic<unsigned int> count[2];
+    };
+
+    static const unsigned int readerSlots = 32;
+
+    // announces a reader for as long as it exists
+    class Reading{
+    private:
+        std::atomic<unsigned int> *counter;
+
+    public:
+        const Schedule *current;
+
+        explicit Reading(const RoundRobin &aRoundRobin){
+            auto &slot = aRoundRobin.readers[readerSlot()];
+            counter = &slot.count[aRoundRobin.epoch.load()];
+            counter -> fetch_add(1);
+            current = aRoundRobin.schedule.load();
+        }
+
+        ~Reading(){
+            counter -> fetch_sub(1);
+        }
+
+        Reading(const Reading &) = delete;
+        Reading &operator=(const Reading &) = delete;
+    };
+
+    // read by every next(), written only by writers
+    std::atomic<Schedule*> schedule;
+    mutable std::atomic<unsigned int> epoch;
+    mutable Readers readers[readerSlots];
+
+    // written by every next(), padded to a cache line of its own
+    char ticketBefore[64];
+    std::atomic<unsigned long long> ticket;
+    char ticketAfter[64];
+
+    // state of the writers
+    mutable std::mutex writing;
+    std::function<unsigned int(const Info&)> weight;
+
+    static unsigned int infoWeight(const Info &info){
+        return info > Info() ? static_cast<unsigned int>(info) : 0;
+    }
+
+    static unsigned int readerSlot();
+    // RETURNS:
+    //    index of the reader counters of the calling thread
+
+    static std::vector<unsigned int> smoothRound(const std::vector<unsigned int> &weights);
+    // RETURNS:
+    //    member of every turn of a round, for the members of given weights
+    // THROWS:
+    //    std::bad_alloc in case of memory allocation failure
+
+    template<unsigned int Inline>
+    std::unique_ptr<Schedule> build(const DLR<Key, Info, Inline> &ring, const Schedule *previous) const;
+    // RETURNS:
+    //    schedule of the elements of the DLR; keys known to the previous
+    //    schedule, if any, keep their health, new ones are up
+    // THROWS:
+    //    std::bad_alloc in case of memory allocation failure
+
+    void publish(std::unique_ptr<Schedule> fresh);
+    // publishes a schedule, and frees the previous one once no reader is
+    // left on it
+
+    bool setHealth(const Key &key, bool up);
+
+
+public:
+
+/***************************************************************************
+*  ROUNDROBIN METHODS
+****************************************************************************/
+
+    /****************************************************
+    *  MEMBER METHODS
+    *****************************************************/
+
+    // constructor, weights are the Info values converted to unsigned int,
+    // Info values of 0 or less give weight 0
+    // PARAMETERS: DLR with the members
+        template<unsigned int Inline>
+        explicit RoundRobin(const DLR<Key, Info, Inline> &ring): RoundRobin(ring, &infoWeight){}
+
+    // constructor
+    // PARAMETERS: DLR with the members,
+    //             function returning the weight of a member from its Info
+        template<unsigned int Inline>
+        RoundRobin(const DLR<Key, Info, Inline> &ring, std::function<unsigned int(const Info&)> aWeight){
+            for(auto &slot : readers){
+                slot.count[0] = 0;
+                slot.count[1] = 0;
+            }
+            epoch = 0;
+            ticket = 0;
+            weight = aWeight;
+            schedule = build(ring, nullptr).release();
+        }
+
+    // destructor, no thread may use the scheduler anymore
+        ~RoundRobin(){
+            delete schedule.load();
+        }
+
+    // cursors are shared by reference between threads
+        RoundRobin(const RoundRobin &) = delete;
+        RoundRobin &operator=(const RoundRobin &) = delete;
+
+
+    /***************************************************************************
+    *  SCHEDULING
+    ****************************************************************************/
+
+    bool next(Key &key, Info &info);
+    // picks the member whose turn it is, moving on to the following turns
+    // while the member is down; constant time while most of the weight is
+    // up, at most a round of turns
+    // PARAMETERS: references receiving Key and Info of the picked member
+    // RETURNS:
+    //    true, if a member was picked
+    //    false, if there are no members, or all of them are down
+    //           or of weight 0; key and info are left unchanged then
+
+    unsigned int size() const;
+    // RETURNS:
+    //    number of members, including the ones marked as down
+
+    unsigned long long roundLength() const;
+    // RETURNS:
+    //    number of turns after which the schedule repeats, including the
+    //    turns of members marked as down
+
+
+    /***************************************************************************
+    *  HEALTH
+    ****************************************************************************/
+
+    bool markDown(const Key &key);
+    // makes next() skip all members of given key, in constant time
+    // PARAMETERS: key of the member(s)
+    // RETURNS:
+    //    true, if the key is a member
+    //    false, if there's no member of given key
+
+    bool markUp(const Key &key);
+    // makes next() pick members of given key again, in constant time
+    // PARAMETERS: key of the member(s)
+    // RETURNS:
+    //    true, if the key is a member
+    //    false, if there's no member of given key
+
+    bool isUp(const Key &key) const;
+    // RETURNS:
+    //    true, if members of given key are picked by next()
+    //    false, if they are marked as down or the key isn't a member
+    // PARAMETERS: key of the member(s)
+
+
+    /***************************************************************************
+    *  MEMBERSHIP
+    ****************************************************************************/
+
+    template<unsigned int Inline>
+    void reload(const DLR<Key, Info, Inline> &ring);
+    // replaces the members with the current elements of the DLR and their
+    // weights; keys that stay members keep their up/down state, new ones
+    // are up. Callers of next() carry on with the old members until the
+    // new ones are published.
+    // !THE DLR MUSTN'T BE MODIFIED DURING THE RELOAD!
+    // PARAMETERS: DLR with the members
+    // THROWS:
+    //    std::bad_alloc in case of memory allocation failure,
+    //    the previous members stay in use then
+
+};
+
+
+/***********************************************************************
+*   IMPLEMENTATION
+************************************************************************/
+
+
+template<typename Key, typename Info, typename Hash>
+bool RoundRobin<Key, Info, Hash>::next(Key &key, Info &info) {
+
+    Reading reading(*this);
+    auto current = reading.current;
+
+    //no members up of non zero weight
+    if(current -> upWeighted.load(std::memory_order_relaxed) == 0)
+        return false;
+
+    auto length = current -> turns.size();
+    auto turn = ticket.fetch_add(1, std::memory_order_relaxed);
+    for(std::size_t probe = 0; probe < length; probe++){
+        auto &member = current -> members[current -> turns[(turn + probe) % length]];
+        if(!current -> down[member.state].load(std::memory_order_relaxed)){
+            key = member.key;
+            info = member.info;
+            return true;
+        }
+    }
+
+    //the last members up went down meanwhile
+    return false;
+
+}
+
+
+//--------------------------------------------------------------------------
+
+
+template<typename Key, typename Info, typename Hash>
+unsigned int RoundRobin<Key, Info, Hash>::size() const {
+
+    Reading reading(*this);
+    return reading.current -> members.size();
+
+}
+
+
+//--------------------------------------------------------------------------
+
+
+template<typename Key, typename Info, typename Hash>
+unsigned long long RoundRobin<Key, Info, Hash>::roundLength() const {
+
+    Reading reading(*this);
+    return reading.current -> turns.size();
+
+}
+
+
+//--------------------------------------------------------------------------
+
+
+template<typename Key, typename Info, typename Hash>
+unsigned int RoundRobin<Key, Info, Hash>::readerSlot() {
+
+    static std::atomic<unsigned int> threads(0);
+    thread_local unsigned int slot = threads.fetch_add(1, std::memory_order_relaxed) % readerSlots;
+    return slot;
+
+}
+
+
+//--------------------------------------------------------------------------
+
+
+template<typename Key, typename Info, typename Hash>
+std::vector<unsigned int> RoundRobin<Key, Info, Hash>::smoothRound(const std::vector<unsigned int> &weights) {
+
+    //turns of every member, the weights divided by their greatest common divisor
+    unsigned long long divisor = 0;
+    unsigned int weighted = 0;
+    for(auto memberWeight : weights){
+        if(memberWeight == 0)
+            continue;
+        weighted++;
+        auto a = divisor, b = static_cast<unsigned long long>(memberWeight);
+        while(b != 0){
+            auto rest = a % b;
+            a = b;
+            b = rest;
+        }
+        divisor = a;
+    }
+
+    std::vector<unsigned long long> turns(weights.size(), 0);
+    unsigned long long total = 0;
+    for(unsigned int i = 0; i < weights.size(); i++){
+        turns[i] = weights[i] / (divisor == 0 ? 1 : divisor);
+        total += turns[i];
+    }
+
+    //too long a round is scaled down, keeping every member in it
+    auto limit = std::max(static_cast<unsigned long long>(turnsPerMember) * weighted,
+                          static_cast<unsigned long long>(minTurns));
+    if(total > limit){
+        auto scale = static_cast<double>(limit) / total;
+        total = 0;
+        for(auto &memberTurns : turns){
+            if(memberTurns == 0)
+                continue;
+            memberTurns = std::max(static_cast<unsigned long long>(memberTurns * scale + 0.5), 1ULL);
+            total += memberTurns;
+        }
+    }
+
+    //the k-th turn of a member of t turns is due at (k + offset) / t of the
+    //round; offsets step by the golden ratio, so that members of the same
+    //weight don't take their turns side by side. The due turns of all
+    //members are merged in order of time, then in order of the DLR.
+    struct Due{
+        unsigned int member;
+        unsigned long long k;
+        double time;
+    };
+    auto later = [](const Due &a, const Due &b){
+        if(a.time != b.time)
+            return a.time > b.time;
+        return a.member > b.member;
+    };
+    std::priority_queue<Due, std::vector<Due>, decltype(later)> due(later);
+    std::vector<double> offsets(turns.size(), 0);
+    double offset = 0;
+    for(unsigned int i = 0; i < turns.size(); i++){
+        if(turns[i] == 0)
+            continue;
+        offsets[i] = offset;
+        offset += 0.6180339887498949;
+        offset -= static_cast<unsigned int>(offset);
+        due.push(Due{i, 0, offsets[i] / turns[i]});
+    }
+
+    std::vector<unsigned int> round;
+    round.reserve(total);
+    while(!due.empty()){
+        auto next = due.top();
+        due.pop();
+        round.push_back(next.member);
+        if(++next.k < turns[next.member]){
+            next.time = (next.k + offsets[next.member]) / turns[next.member];
+            due.push(next);
+        }
+    }
+
+    return round;
+
+}
+
+
+//--------------------------------------------------------------------------
+
+
+template<typename Key, typename Info, typename Hash>
+template<unsigned int Inline>
+std::unique_ptr<typename RoundRobin<Key, Info, Hash>::Schedule>
+RoundRobin<Key, Info, Hash>::build(const DLR<Key, Info, Inline> &ring, const Schedule *previous) const {
+
+    std::unique_ptr<Schedule> fresh(new Schedule());
+    unsigned int count = ring.length();
+    fresh -> members.reserve(count);
+
+    //copy the members, numbering the health flags of their keys
+    std::vector<unsigned int> weights;
+    weights.reserve(count);
+    auto travel = ring.begin();
+    for(unsigned int i = 0; i < count; i++, ++travel){
+        auto content = *travel;
+
+        auto state = fresh -> states.insert(std::make_pair(content.key, fresh -> states.size())).first -> second;
+        fresh -> members.push_back(Member{content.key, content.info, state});
+        weights.push_back(weight(content.info));
+    }
+
+    fresh -> turns = smoothRound(weights);
+
+    //health flags, the known keys keep theirs
+    auto keys = fresh -> states.size();
+    fresh -> down.reset(new std::atomic<bool>[keys]);
+    fresh -> weighted.assign(keys, false);
+    for(auto &state : fresh -> states){
+        bool down = false;
+        if(previous != nullptr){
+            auto known = previous -> states.find(state.first);
+            if(known != previous -> states.end())
+                down = previous -> down[known -> second].load();
+        }
+        fresh -> down[state.second].store(down);
+    }
+
+    unsigned int upWeighted = 0;
+    for(unsigned int i = 0; i < count; i++){
+        auto state = fresh -> members[i].state;
+        if(weights[i] != 0 && !fresh -> weighted[state]){
+            fresh -> weighted[state] = true;
+            if(!fresh -> down[state].load())
+                upWeighted++;
+        }
+    }
+    fresh -> upWeighted.store(upWeighted);
+
+    return fresh;
+
+}
+
+
+//--------------------------------------------------------------------------
+
+
+template<typename Key, typename Info, typename Hash>
+void RoundRobin<Key, Info, Hash>::publish(std::unique_ptr<Schedule> fresh) {
+
+    auto previous = schedule.exchange(fresh.release());
+
+    //two flips, so that readers which took the epoch during the previous
+    //writer's flips are waited for as well
+    for(int flip = 0; flip < 2; flip++){
+        auto old = epoch.load();
+        epoch.store(old ^ 1);
+        for(auto &slot : readers){
+            while(slot.count[old].load() != 0)
+                std::this_thread::yield();
+        }
+    }
+
+    delete previous;
+
+}
+
+
+//--------------------------------------------------------------------------
+
+
+template<typename Key, typename Info, typename Hash>
+bool RoundRobin<Key, Info, Hash>::setHealth(const Key &key, bool up) {
+
+    //only writers replace the schedule, so it can't go away meanwhile
+    std::lock_guard<std::mutex> guard(writing);
+    auto current = schedule.load();
+
+    auto found = current -> states.find(key);
+    if(found == current -> states.end())
+        return false;
+
+    auto state = found -> second;
+    if(current -> down[state].load() != up)
+        return true;
+
+    current -> down[state].store(!up);
+    if(current -> weighted[state]){
+        if(up)
+            current -> upWeighted.fetch_add(1);
+        else
+            current -> upWeighted.fetch_sub(1);
+    }
+
+    return true;
+
+}
+
+
+//--------------------------------------------------------------------------
+
+
+template<typename Key, typename Info, typename Hash>
+bool RoundRobin<Key, Info, Hash>::markDown(const Key &key) {
+
+    return setHealth(key, false);
+
+}
+
+
+//--------------------------------------------------------------------------
+
+
+template<typename Key, typename Info, typename Hash>
+bool RoundRobin<Key, Info, Hash>::markUp(const Key &key) {
+
+    return setHealth(key, true);
+
+}
+
+
+//--------------------------------------------------------------------------
+
+
+template<typename Key, typename Info, typename Hash>
+bool RoundRobin<Key, Info, Hash>::isUp(const Key &key) const {
+
+    std::lock_guard<std::mutex> guard(writing);
+    auto current = schedule.load();
+
+    auto found = current -> states.find(key);
+    return found != current -> states.end() && !current -> down[found -> second].load();
+
+}
+
+
+//--------------------------------------------------------------------------
+
+
+template<typename Key, typename Info, typename Hash>
+template<unsigned int Inline>
+void RoundRobin<Key, Info, Hash>::reload(const DLR<Key, Info, Inline> &ring) {
+
+    std::lock_guard<std::mutex> guard(writing);
+    publish(build(ring, schedule.load()));
+
+}
+
+
+#endif //EADS2_ROUNDROBIN_H
@@ -0,0 +1,291 @@
+//
+// Created by Ernest Pokropek
+//
+
+
+/***************************************************************************
+* ShardedDLR is a set of DLRs sharing the load of keyed operations, so
+* that many threads can modify it at the same time. Every Key is hashed
+* to one of the shards (internal DLRs), and each shard is guarded by its
+* own lock. As all the nodes of a given Key land in the same shard, the
+* occurrence indexes of a Key behave exactly like in a single DLR.
+*
+* Operations concerning the whole container (length, forEach) visit the
+* shards one after another, locking each of them in turn. They are not
+* a snapshot of the whole container when other threads keep modifying it.
+*
+* Nomenclature:
+ * shard -> single DLR of the container together with its lock
+****************************************************************************/
+
+#ifndef EADS2_SHARDEDDLR_H
+#define EADS2_SHARDEDDLR_H
+
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "DLR.h"
+
+template<typename Key, typename Info, typename Hash = std::hash<Key>>
+class ShardedDLR{
+
+private:
+
+/***************************************************************************
+*  SHARD DECLARATION
+****************************************************************************/
+
+    // followed by a cache line of padding, so that locking one shard doesn't
+    // slow down its neighbours; alignas wouldn't do, as std::vector ignores
+    // alignment beyond the default one before C++17
+    struct Shard{
+        std::mutex lock;
+        DLR<Key, Info> ring;
+        char padding[64];
+    };
+
+    std::vector<Shard> shards;
+    Hash hash;
+
+    // std::hash of integers is the identity, so keys sharing a stride with
+    // the number of shards would all land in one shard without mixing
+    Shard &shardOf(const Key &key){
+        return shards[DLR<Key, Info>::mix(hash(key)) % shards.size()];
+    }
+
+
+public:
+
+/***************************************************************************
+*  SHARDEDDLR METHODS
+****************************************************************************/
+
+    /****************************************************
+    *  MEMBER METHODS
+    *****************************************************/
+
+    // default constructor, one shard per hardware thread
+        ShardedDLR(): ShardedDLR(std::thread::hardware_concurrency()){}
+
+    // constructor
+    // PARAMETERS: number of shards, 0 is treated as 1
+        explicit ShardedDLR(unsigned int shardCount): shards(shardCount == 0 ? 1 : shardCount){}
+
+    // default destructor
+        ~ShardedDLR() = default;
+
+    // shards own locks, so the container can't be copied
+        ShardedDLR(const ShardedDLR &) = delete;
+        ShardedDLR &operator=(const ShardedDLR &) = delete;
+
+
+    /***************************************************************************
+    *  CAPACITY
+    ****************************************************************************/
+
+    unsigned int shardCount() const;
+    // RETURNS:
+    //    number of internal DLRs
+
+    bool exists(const Key &key);
+    // RETURNS:
+    //    true, if the element exists in the container
+    //    false, if the element doesn't exist in the container
+    // PARAMETERS: key of the sought node
+
+    unsigned int howMany(const Key &aKey);
+    // RETURNS:
+    //   an integer number of how much elements of given
+    //   key there are in the container
+    // PARAMETERS: key of the sought node(s)
+
+    bool isEmpty();
+    // RETURNS:
+    //    true, if none of the shards has elements
+    //    false, if at least one shard has an element
+
+    unsigned int length();
+    // RETURNS:
+    //    number of nodes in all the shards
+
+
+    /***************************************************************************
+    *  ITERATION
+    ****************************************************************************/
+
+    template<typename Function>
+    void forEach(Function function);
+    // calls function(key, info) for every element, shard after shard,
+    // in the order of elements inside each shard
+    // PARAMETERS: callable taking (const Key&, Info&)
+    // !THE SHARD BEING VISITED STAYS LOCKED, THE FUNCTION MUSTN'T MODIFY THE CONTAINER!
+
+
+    /***************************************************************************
+    *  MODIFIERS
+    ****************************************************************************/
+
+    void pushBack(const Key &newKey, const Info &newInfo);
+    // inserts a new element at the end of the shard owning the key
+    // PARAMETERS: Key and Info of new node
+    // THROWS:
+    //    std::bad_alloc in case of memory allocation failure
+
+    bool remove(const Key &key, int occurrence = 1);
+    // removes given element from the container
+    // PARAMETERS: Key of the node to remove,
+    //             number of node's occurrence, defaultly 1
+    // RETURNS:
+    //    true, if the element has been removed
+    //    false, if there's no such element
+
+    void clear();
+    // removes every element from every shard
+
+};
+
+
+/***********************************************************************
+*   IMPLEMENTATION
+************************************************************************/
+
+
+template<typename Key, typename Info, typename Hash>
+unsigned int ShardedDLR<Key, Info, Hash>::shardCount() const {
+
+    return shards.size();
+
+}
+
+
+//--------------------------------------------------------------------------
+
+
+template<typename Key, typename Info, typename Hash>
+bool ShardedDLR<Key, Info, Hash>::exists(const Key &key) {
+
+    auto &shard = shardOf(key);
+    std::lock_guard<std::mutex> guard(shard.lock);
+    return shard.ring.exists(key);
+
+}
+
+
+//--------------------------------------------------------------------------
+
+
+template<typename Key, typename Info, typename Hash>
+unsigned int ShardedDLR<Key, Info, Hash>::howMany(const Key &aKey) {
+
+    auto &shard = shardOf(aKey);
+    std::lock_guard<std::mutex> guard(shard.lock);
+    return shard.ring.howMany(aKey);
+
+}
+
+
+//--------------------------------------------------------------------------
+
+
+template<typename Key, typename Info, typename Hash>
+bool ShardedDLR<Key, Info, Hash>::isEmpty() {
+
+    for(auto &shard : shards){
+        std::lock_guard<std::mutex> guard(shard.lock);
+        if(!shard.ring.isEmpty())
+            return false;
+    }
+
+    return true;
+
+}
+
+
+//--------------------------------------------------------------------------
+
+
+template<typename Key, typename Info, typename Hash>
+unsigned int ShardedDLR<Key, Info, Hash>::length() {
+
+    unsigned int count = 0;
+    for(auto &shard : shards){
+        std::lock_guard<std::mutex> guard(shard.lock);
+        count += shard.ring.length();
+    }
+
+    return count;
+
+}
+
+
+//--------------------------------------------------------------------------
+
+
+template<typename Key, typename Info, typename Hash>
+template<typename Function>
+void ShardedDLR<Key, Info, Hash>::forEach(Function function) {
+
+    for(auto &shard : shards){
+        std::lock_guard<std::mutex> guard(shard.lock);
+
+        //empty shard
+        if(shard.ring.isEmpty())
+            continue;
+
+        auto travel = shard.ring.begin();
+        do{
+            auto content = *travel;
+            function(static_cast<const Key&>(content.key), content.info);
+            ++travel;
+
+        }while(travel != shard.ring.begin());
+    }
+
+}
+
+
+//--------------------------------------------------------------------------
+
+
+template<typename Key, typename Info, typename Hash>
+void ShardedDLR<Key, Info, Hash>::pushBack(const Key &newKey, const Info &newInfo) {
+
+    auto &shard = shardOf(newKey);
+    std::lock_guard<std::mutex> guard(shard.lock);
+    shard.ring.pushBack(newKey, newInfo);
+
+}
+
+
+//--------------------------------------------------------------------------
+
+
+template<typename Key, typename Info, typename Hash>
+bool ShardedDLR<Key, Info, Hash>::remove(const Key &key, int occurrence) {
+
+    //a single traversal under the lock, which reports nothing on std::cerr
+    auto &shard = shardOf(key);
+    std::lock_guard<std::mutex> guard(shard.lock);
+    return shard.ring.remove(shard.ring.find(key, occurrence));
+
+}
+
+
+//--------------------------------------------------------------------------
+
+
+template<typename Key, typename Info, typename Hash>
+void ShardedDLR<Key, Info, Hash>::clear() {
+
+    for(auto &shard : shards){
+        std::lock_guard<std::mutex> guard(shard.lock);
+        if(!shard.ring.isEmpty())
+            shard.ring.clear();
+    }
+
+}
+
+
+#endif //EADS2_SHARDEDDLR_H
@@ -0,0 +1,221 @@
+//
+// Created by Ernest Pokropek
+//
+
+
+/***************************************************************************
+* Tests of the relinking algorithms: partition, split, mergeSorted,
+* interleave, reverse, rotate and sort. Each of them is run on random DLRs,
+* with and without inline nodes, and compared with the same operation
+* done on a model by the standard library.
+****************************************************************************/
+
+#include <algorithm>
+#include <functional>
+
+#include "TestUtil.h"
+
+
+// RETURNS: model of given length, keys from a small range so they repeat,
+//          infos numbering the elements so the order of equal keys shows
+static Model randomModel(int length){
+
+    Model model;
+    for(int i = 0; i < length; i++)
+        model.push_back(std::make_pair(randomIn(0, length / 4 + 1), i));
+    return model;
+
+}
+
+
+static bool byKey(const std::pair<int, int> &first, const std::pair<int, int> &second){
+    return first.first < second.first;
+}
+
+
+// the algorithms must keep the content hash of both DLRs up to date, and
+// move nodes of blocks as well as single ones
+template<unsigned int Inline>
+static void prepared(DLR<int, int, Inline> &first, DLR<int, int, Inline> &second){
+    if(randomIn(0, 1) == 1)
+        first.compact();
+    if(randomIn(0, 1) == 1)
+        second.compact();
+    first.enableHash();
+    second.enableHash();
+}
+
+
+template<unsigned int Inline>
+static void partition(){
+
+    auto model = randomModel(randomIn(0, 200));
+    auto rejectedModel = randomModel(randomIn(0, 5));
+    auto ring = ringOf<int, int, Inline>(model);
+    auto rejected = ringOf<int, int, Inline>(rejectedModel);
+    prepared(ring, rejected);
+
+    int pivot = randomIn(0, 50);
+    auto keep = [pivot](const int &key, const int &){ return key < pivot; };
+    ring.partition(keep, rejected);
+
+    auto split = std::stable_partition(model.begin(), model.end(),
+                                       [pivot](const std::pair<int, int> &element){ return element.first < pivot; });
+    rejectedModel.insert(rejectedModel.end(), split, model.end());
+    model.erase(split, model.end());
+
+    checkRing(ring, model);
+    checkRing(rejected, rejectedModel);
+
+}
+
+
+template<unsigned int Inline>
+static void split(){
+
+    auto model = randomModel(randomIn(1, 200));
+    auto tailModel = randomModel(randomIn(0, 5));
+    auto ring = ringOf<int, int, Inline>(model);
+    auto tail = ringOf<int, int, Inline>(tailModel);
+    prepared(ring, tail);
+
+    int at = randomIn(0, model.size() - 1);
+    ring.split(ring.begin() + at, tail);
+
+    tailModel.insert(tailModel.end(), model.begin() + at, model.end());
+    model.erase(model.begin() + at, model.end());
+
+    checkRing(ring, model);
+    checkRing(tail, tailModel);
+
+}
+
+
+template<unsigned int Inline>
+static void mergeSorted(){
+
+    auto model = randomModel(randomIn(0, 200));
+    auto otherModel = randomModel(randomIn(0, 200));
+    for(auto &element : otherModel)
+        element.second += 1000;
+    std::stable_sort(model.begin(), model.end(), byKey);
+    std::stable_sort(otherModel.begin(), otherModel.end(), byKey);
+
+    auto ring = ringOf<int, int, Inline>(model);
+    auto other = ringOf<int, int, Inline>(otherModel);
+    prepared(ring, other);
+
+    ring.mergeSorted(other);
+
+    Model merged;
+    std::merge(model.begin(), model.end(), otherModel.begin(), otherModel.end(), std::back_inserter(merged), byKey);
+
+    checkRing(ring, merged);
+    checkRing(other, Model());
+
+}
+
+
+template<unsigned int Inline>
+static void interleave(){
+
+    auto model = randomModel(randomIn(0, 100));
+    auto otherModel = randomModel(randomIn(0, 100));
+    auto ring = ringOf<int, int, Inline>(model);
+    auto other = ringOf<int, int, Inline>(otherModel);
+    prepared(ring, other);
+
+    ring.interleave(other);
+
+    Model interleaved;
+    for(unsigned int i = 0; i < std::max(model.size(), otherModel.size()); i++){
+        if(i < model.size())
+            interleaved.push_back(model[i]);
+        if(i < otherModel.size())
+            interleaved.push_back(otherModel[i]);
+    }
+
+    checkRing(ring, interleaved);
+    checkRing(other, Model());
+
+}
+
+
+template<unsigned int Inline>
+static void reverseAndRotate(){
+
+    auto model = randomModel(randomIn(0, 200));
+    auto ring = ringOf<int, int, Inline>(model);
+    ring.enableHash();
+
+    ring.reverse();
+    std::reverse(model.begin(), model.end());
+    checkRing(ring, model);
+
+    if(model.empty())
+        return;
+
+    int moveBy = randomIn(-500, 500);
+    ring.rotate(moveBy);
+    int size = model.size();
+    std::rotate(model.begin(), model.begin() + ((moveBy % size) + size) % size, model.end());
+    checkRing(ring, model);
+
+}
+
+
+template<unsigned int Inline>
+static void sort(int maxLength){
+
+    auto model = randomModel(randomIn(0, maxLength));
+
+    //some already sorted runs, which the natural merge sort picks up
+    if(randomIn(0, 1) == 1 && model.size() > 10)
+        std::sort(model.begin() + model.size() / 3, model.end() - model.size() / 3, byKey);
+
+    auto ring = ringOf<int, int, Inline>(model);
+    ring.enableHash();
+
+    if(randomIn(0, 1) == 0){
+        ring.sort();
+        std::stable_sort(model.begin(), model.end(), byKey);
+    }
+    else{
+        ring.sort(std::greater<int>());
+        std::stable_sort(model.begin(), model.end(),
+                         [](const std::pair<int, int> &first, const std::pair<int, int> &second){
+                             return first.first > second.first;
+                         });
+    }
+
+    checkRing(ring, model);
+
+}
+
+
+template<unsigned int Inline>
+static void all(){
+
+    for(int i = 0; i < 200; i++){
+        partition<Inline>();
+        split<Inline>();
+        mergeSorted<Inline>();
+        interleave<Inline>();
+        reverseAndRotate<Inline>();
+        sort<Inline>(300);
+    }
+
+}
+
+
+int main(){
+
+    all<0>();
+    all<4>();
+
+    //long ring, many merge passes
+    sort<0>(100000);
+
+    return 0;
+
+}
@@ -0,0 +1,109 @@
+//
+// Created by Ernest Pokropek
+//
+
+
+/***************************************************************************
+* Tests of compaction: compact(), automatic compaction, the fragmentation
+* measure, and blocks of nodes, also when their nodes are spread over
+* several DLRs.
+****************************************************************************/
+
+#include <string>
+
+#include "TestUtil.h"
+
+
+static void fragmentation(){
+
+    DLR<int, std::string> ring;
+    CHECK(ring.fragmentation() == 0);
+
+    //a fresh load is mostly in allocation order
+    for(int i = 0; i < 5000; i++)
+        ring.pushBack(i, std::to_string(i));
+    CHECK(ring.fragmentation() < 0.1);
+
+    //scatter it, then compact it
+    for(int i = 0; i < 5000; i += 3)
+        ring.remove(i);
+    for(int i = 0; i < 5000; i += 3)
+        ring.insertAfter(ring.begin() + randomIn(0, 2000), i, std::to_string(i));
+
+    auto before = contentOf(ring);
+    CHECK(ring.fragmentation() > 0.1);
+
+    ring.compact();
+    CHECK(ring.fragmentation() == 0);
+    CHECK(contentOf(ring) == before);
+
+    //compacting twice gives a new block, the old one goes away
+    ring.compact();
+    CHECK(ring.fragmentation() == 0);
+    CHECK(contentOf(ring) == before);
+
+}
+
+
+static void sharedBlocks(){
+
+    //nodes of one block spread over two DLRs, released in any order
+    for(int round = 0; round < 20; round++){
+        Model model;
+        for(int i = 0; i < 3000; i++)
+            model.push_back(std::make_pair(i, randomIn(0, 100)));
+        DLR<int, int> ring;
+        ring.pushBack(model);
+        ring.compact();
+
+        DLR<int, int> other;
+        int at = randomIn(0, model.size() - 1);
+        ring.split(ring.begin() + at, other);
+        checkRing(other, Model(model.begin() + at, model.end()));
+
+        while(!ring.isEmpty() || !other.isEmpty()){
+            auto &from = randomIn(0, 1) == 0 || other.isEmpty() ? ring : other;
+            if(from.isEmpty())
+                continue;
+            from.remove(from.begin() + randomIn(0, 5));
+        }
+    }
+
+}
+
+
+static void manyBlocks(){
+
+    //every pushBack of several elements makes a block of its own
+    DLR<int, int> ring;
+    Model model;
+    for(int i = 0; i < 20000; i++){
+        ring.pushBack(Model{{i, i}});
+        model.push_back(std::make_pair(i, i));
+    }
+    checkRing(ring, model);
+
+    //every second one, 'any' moves past the removed element each time
+    for(int i = 0; i < 10000; i++)
+        CHECK(ring.remove(ring.begin() + 1));
+    CHECK(ring.length() == 10000);
+    CHECK(!ring.exists(1) && ring.exists(2) && !ring.exists(19999));
+
+    //and the rest
+    while(!ring.isEmpty())
+        CHECK(ring.remove(ring.begin()));
+
+}
+
+
+int main(){
+
+    randomOperations<0>(false, 0);
+    randomOperations<0>(false, 0.3);
+    fragmentation();
+    sharedBlocks();
+    manyBlocks();
+
+    return 0;
+
+}
@@ -0,0 +1,87 @@
+//
+// Created by Ernest Pokropek
+//
+
+
+/***************************************************************************
+* Tests of the content hash and of comparing DLRs, also after elements
+* have been written through an Iterator, which the hash can't notice.
+****************************************************************************/
+
+#include <algorithm>
+
+#include "TestUtil.h"
+
+
+static void hashAndEquality(){
+
+    Model model;
+    for(int i = 0; i < 300; i++)
+        model.push_back(std::make_pair(randomIn(0, 50), randomIn(0, 50)));
+
+    auto first = ringOf<int, int>(model);
+    auto second = ringOf<int, int>(model);
+    first.enableHash();
+    second.enableHash();
+    CHECK(first.hash() == second.hash());
+    CHECK(first == second);
+
+    //same elements in another order
+    std::swap(model[10], model[200]);
+    auto swapped = ringOf<int, int>(model);
+    swapped.enableHash();
+    CHECK(model[10] == model[200] || swapped.hash() != first.hash());
+    CHECK(model[10] == model[200] || swapped != first);
+
+    //a rotated ring is another starting point of the same ring
+    first.rotate(7);
+    CHECK(first.hash() == second.hash());
+    first.rotate(-7);
+
+    first.disableHash();
+    CHECK(first.hash() == 0);
+    CHECK(first == second);
+
+}
+
+
+static void staleHash(){
+
+    Model model;
+    for(int i = 0; i < 100; i++)
+        model.push_back(std::make_pair(i, i));
+
+    auto first = ringOf<int, int>(model);
+    auto second = ringOf<int, int>(model);
+    first.enableHash();
+    second.enableHash();
+
+    //a write through an Iterator leaves the hash of the first DLR stale
+    auto hash = first.hash();
+    (*(first.begin() + 40)).info = -1;
+    CHECK(first.hash() == hash);
+    CHECK(first != second);
+
+    //writing the same into the second one makes them equal, although
+    //the hashes differ now
+    (*(second.begin() + 40)).info = -1;
+    second.enableHash();
+    CHECK(first.hash() != second.hash());
+    CHECK(first == second);
+    CHECK(!(first != second));
+
+    //recomputing the stale hash brings it up to date
+    first.enableHash();
+    CHECK(first.hash() == second.hash());
+
+}
+
+
+int main(){
+
+    hashAndEquality();
+    staleHash();
+
+    return 0;
+
+}
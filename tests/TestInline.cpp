@@ -0,0 +1,115 @@
+//
+// Created by Ernest Pokropek
+//
+
+
+/***************************************************************************
+* Tests of inline storage: nodes kept inside the DLR object, moving over to
+* other DLRs, spilling to the heap, and compaction keeping them in place.
+****************************************************************************/
+
+#include <string>
+
+#include "TestUtil.h"
+
+
+// RETURNS: number of elements of the DLR stored inside the DLR object
+template<typename Key, typename Info, unsigned int Inline>
+static unsigned int inlineCount(DLR<Key, Info, Inline> &ring){
+
+    auto first = reinterpret_cast<const char*>(&ring);
+    unsigned int count = 0;
+    auto travel = ring.begin();
+    for(unsigned int i = 0; i < ring.length(); i++, ++travel){
+        auto content = *travel;
+        auto address = reinterpret_cast<const char*>(&content.key);
+        if(address >= first && address < first + sizeof(ring))
+            count++;
+    }
+    return count;
+
+}
+
+
+static void inlineStorage(){
+
+    CHECK(sizeof(DLR<int, int>) < sizeof(DLR<int, int, 1>));
+
+    DLR<int, std::string, 4> ring;
+    for(int i = 0; i < 4; i++)
+        ring.pushBack(i, std::to_string(i));
+    CHECK(inlineCount(ring) == 4);
+
+    //copies don't share inline nodes
+    DLR<int, std::string, 4> copy(ring);
+    ring.remove(0);
+    ring.pushBack(9, "9");
+    CHECK(copy.length() == 4);
+    CHECK(contentOf(copy)[0].second == "0");
+
+    copy = ring;
+    CHECK(copy == ring);
+
+    //inline nodes move over to another DLR
+    DLR<int, std::string, 4> other;
+    other.pushBack(100, "100");
+    other.interleave(ring);
+    CHECK(ring.isEmpty());
+    CHECK(other.length() == 5);
+    ring.pushBack(std::vector<std::pair<int, std::string>>{{1, "a"}, {2, "b"}, {3, "c"}, {4, "d"}, {5, "e"}});
+    CHECK(inlineCount(ring) == 4);
+    ring.mergeSorted(other);
+    CHECK(ring.length() == 10);
+
+}
+
+
+static void compactSpilled(){
+
+    //a ring spilled to the heap keeps its inline nodes through compaction
+    DLR<int, std::string, 4> ring;
+    for(int i = 0; i < 200; i++)
+        ring.pushBack(i, std::to_string(i));
+    for(int i = 0; i < 200; i += 3)
+        ring.remove(i);
+    for(int i = 0; i < 200; i += 3)
+        ring.insertAfter(ring.begin() + randomIn(0, 100), i, std::to_string(i));
+
+    auto before = contentOf(ring);
+    auto inlined = inlineCount(ring);
+    CHECK(inlined == 4);
+
+    ring.compact();
+    CHECK(contentOf(ring) == before);
+    CHECK(inlineCount(ring) == inlined);
+
+    //the first elements are the inline ones, a freed slot is taken again
+    CHECK(ring.remove(1));
+    CHECK(inlineCount(ring) == 3);
+    ring.compact();
+    CHECK(inlineCount(ring) == 3);
+    ring.pushBack(1000, "1000");
+    CHECK(inlineCount(ring) == 4);
+
+    //a ring with only inline nodes is left as it is
+    DLR<int, std::string, 4> small;
+    small.pushBack(1, "1");
+    small.pushBack(2, "2");
+    small.compact();
+    CHECK(inlineCount(small) == 2);
+    CHECK(contentOf(small) == (std::vector<std::pair<int, std::string>>{{1, "1"}, {2, "2"}}));
+
+}
+
+
+int main(){
+
+    randomOperations<4>(false, 0);
+    randomOperations<4>(false, 0.3);
+    randomOperations<4>(true, 0);
+    inlineStorage();
+    compactSpilled();
+
+    return 0;
+
+}
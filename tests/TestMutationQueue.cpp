@@ -0,0 +1,232 @@
+//
+// Created by Ernest Pokropek
+//
+
+
+/***************************************************************************
+* Tests of MutationQueue: batches submitted by many threads, applied by
+* an applier thread, and the results reported through their futures.
+* Meant to be run with the thread sanitizer.
+****************************************************************************/
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+#include "MutationQueue.h"
+#include "TestUtil.h"
+
+
+static void concurrentBatches(){
+
+    const int threads = 8, pushes = 2000;
+    DLR<int, int> ring;
+    ring.enableHash();
+    MutationQueue<int, int> queue(ring);
+    std::thread applier([&queue]{ queue.run(); });
+
+    std::vector<std::thread> submitters;
+    for(int t = 0; t < threads; t++){
+        submitters.emplace_back([&queue, t]{
+            MutationQueue<int, int>::Batch batch;
+            std::vector<std::future<std::vector<bool>>> futures;
+            for(int i = 0; i < pushes; i++){
+                batch.pushBack(t * pushes + i, t);
+                if(batch.size() == 50)
+                    futures.push_back(queue.submit(batch));
+            }
+            futures.push_back(queue.submit(batch));
+
+            //keyed modifications refer to this thread's own elements
+            batch.insertAfter(t * pushes, -1 - t, t);
+            batch.insertBefore(t * pushes + 1, -100 - t, t);
+            batch.remove(t * pushes + 2);
+            batch.remove(-12345);
+            batch.insertAfter(-12345, 0, 0);
+            batch.remove(t * pushes + 3, 2);
+            auto results = queue.submit(batch).get();
+            CHECK((results == std::vector<bool>{true, true, true, false, false, false}));
+
+            for(auto &future : futures){
+                auto pushed = future.get();
+                CHECK(pushed.size() <= 50);
+                CHECK(std::find(pushed.begin(), pushed.end(), false) == pushed.end());
+            }
+        });
+    }
+
+    //a reader looking at the DLR meanwhile
+    for(int i = 0; i < 100; i++)
+        queue.read([](DLR<int, int> &shared){ shared.length(); });
+
+    for(auto &submitter : submitters)
+        submitter.join();
+    queue.stop();
+    applier.join();
+
+    CHECK(ring.length() == threads * (pushes + 1));
+    for(int t = 0; t < threads; t++){
+        CHECK(ring.exists(-1 - t) && ring.exists(-100 - t));
+        CHECK(!ring.exists(t * pushes + 2));
+    }
+
+    DLR<int, int> fresh(ring);
+    fresh.enableHash();
+    CHECK(fresh.hash() == ring.hash());
+
+}
+
+
+static void orderAndInline(){
+
+    //batches without an applier thread, applied in the order of submission
+    DLR<int, std::string, 4> ring;
+    MutationQueue<int, std::string, 4> queue(ring);
+
+    MutationQueue<int, std::string, 4>::Batch first, second;
+    first.pushBack(1, "one");
+    first.pushBack(2, "two");
+    second.pushBack(3, "three");
+    second.insertBefore(1, 0, "zero");
+    second.pushBack(4, "four");
+    second.remove(2);
+    auto firstResults = queue.submit(first);
+    auto secondResults = queue.submit(second);
+    CHECK(first.size() == 0);
+
+    CHECK(queue.apply() == 2);
+    CHECK(queue.apply() == 0);
+    CHECK((firstResults.get() == std::vector<bool>{true, true}));
+    CHECK((secondResults.get() == std::vector<bool>{true, true, true, true}));
+
+    std::vector<std::pair<int, std::string>> model{{3, "three"}, {0, "zero"}, {4, "four"}, {1, "one"}};
+    std::lock_guard<std::mutex> guard(queue.mutex());
+    checkRing(ring, model);
+
+}
+
+
+// Info whose copies throw once the allowed number of copies is used up,
+// negative for no limit
+static int copiesAllowed = -1;
+
+struct Fragile{
+    int value;
+    Fragile(int aValue = 0): value(aValue){}
+    Fragile(const Fragile &aFragile): value(aFragile.value){
+        if(copiesAllowed == 0)
+            throw std::runtime_error("copying forbidden");
+        if(copiesAllowed > 0)
+            copiesAllowed--;
+    }
+    Fragile &operator=(const Fragile &) = default;
+    bool operator==(const Fragile &aFragile) const{
+        return value == aFragile.value;
+    }
+};
+
+
+static void failures(){
+
+    DLR<int, Fragile> ring;
+    MutationQueue<int, Fragile> queue(ring);
+
+    MutationQueue<int, Fragile>::Batch first, failing, last;
+    first.pushBack(1, Fragile(1));
+    first.pushBack(2, Fragile(2));
+    auto firstResults = queue.submit(first);
+    CHECK(queue.apply() == 1);
+    CHECK(firstResults.get().size() == 2);
+
+    //the insert throws, the rest of its batch isn't applied, other batches are
+    failing.insertAfter(1, 3, Fragile(3));
+    failing.remove(2);
+    last.remove(1);
+    auto failingResults = queue.submit(failing);
+    auto lastResults = queue.submit(last);
+
+    copiesAllowed = 0;
+    queue.apply();
+    copiesAllowed = -1;
+
+    bool threw = false;
+    try{
+        failingResults.get();
+    }
+    catch(std::runtime_error &){
+        threw = true;
+    }
+    CHECK(threw);
+    CHECK((lastResults.get() == std::vector<bool>{true}));
+    CHECK(ring.length() == 1 && ring.exists(2));
+
+}
+
+
+// RETURNS: true, if the future reports an exception
+static bool failed(std::future<std::vector<bool>> &future){
+
+    try{
+        future.get();
+    }
+    catch(std::runtime_error &){
+        return true;
+    }
+    return false;
+
+}
+
+
+static void failureAttribution(){
+
+    DLR<int, Fragile> ring;
+    MutationQueue<int, Fragile> queue(ring);
+
+    //copies of a pushed Info made by apply(), the last one creates the node
+    MutationQueue<int, Fragile>::Batch batch;
+    batch.pushBack(5, Fragile(5));
+    batch.pushBack(6, Fragile(6));
+    auto loaded = queue.submit(batch);
+    copiesAllowed = 1000;
+    queue.apply();
+    int copies = (1000 - copiesAllowed) / 2;
+    copiesAllowed = -1;
+    CHECK(loaded.get().size() == 2);
+
+    //the pushBack of the second batch is lost when creating its node, the
+    //fourth one already while gathering it; the batches around them
+    //neither pushed anything nor had anything lost
+    MutationQueue<int, Fragile>::Batch first, second, third, fourth;
+    first.remove(5);
+    second.pushBack(7, Fragile(7));
+    third.remove(6);
+    fourth.pushBack(8, Fragile(8));
+    auto firstResults = queue.submit(first);
+    auto secondResults = queue.submit(second);
+    auto thirdResults = queue.submit(third);
+    auto fourthResults = queue.submit(fourth);
+
+    copiesAllowed = copies - 1;
+    CHECK(queue.apply() == 4);
+    copiesAllowed = -1;
+
+    CHECK((firstResults.get() == std::vector<bool>{true}));
+    CHECK(failed(secondResults));
+    CHECK((thirdResults.get() == std::vector<bool>{true}));
+    CHECK(failed(fourthResults));
+    CHECK(ring.isEmpty());
+
+}
+
+
+int main(){
+
+    concurrentBatches();
+    orderAndInline();
+    failures();
+    failureAttribution();
+
+    return 0;
+
+}
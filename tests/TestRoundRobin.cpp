@@ -0,0 +1,210 @@
+//
+// Created by Ernest Pokropek
+//
+
+
+/***************************************************************************
+* Tests of RoundRobin: the smooth weighted order of picks, health of members,
+* reloading, and many threads picking while others change the members.
+* Meant to be run with the thread sanitizer.
+****************************************************************************/
+
+#include <algorithm>
+#include <atomic>
+#include <map>
+#include <string>
+#include <thread>
+
+#include "RoundRobin.h"
+#include "TestUtil.h"
+
+
+// RETURNS: how many times every key has been picked in given number of picks
+static std::map<std::string, unsigned int> picks(RoundRobin<std::string, int> &scheduler, unsigned long long count){
+
+    std::map<std::string, unsigned int> counts;
+    std::string key;
+    int info;
+    for(unsigned long long i = 0; i < count; i++){
+        CHECK(scheduler.next(key, info));
+        counts[key]++;
+    }
+    return counts;
+
+}
+
+
+static void weights(){
+
+    DLR<std::string, int> ring;
+    ring.pushBack("a", 5);
+    ring.pushBack("b", 1);
+    ring.pushBack("c", 2);
+    ring.pushBack("never", -3);
+    ring.pushBack("zero", 0);
+
+    //negative weights are 0, not huge
+    RoundRobin<std::string, int> scheduler(ring);
+    CHECK(scheduler.size() == 5);
+    CHECK(scheduler.roundLength() == 8);
+
+    //every round picks each member as many times as its weight
+    for(int round = 0; round < 3; round++){
+        auto counts = picks(scheduler, scheduler.roundLength());
+        CHECK(counts.size() == 3);
+        CHECK(counts["a"] == 5 && counts["b"] == 1 && counts["c"] == 2);
+    }
+
+    //picks of equal weights alternate
+    DLR<std::string, int> equal;
+    equal.pushBack("x", 4);
+    equal.pushBack("y", 4);
+    RoundRobin<std::string, int> alternating(equal);
+    std::string key, previous;
+    int info;
+    for(int i = 0; i < 16; i++){
+        CHECK(alternating.next(key, info));
+        CHECK(key != previous);
+        CHECK(info == 4);
+        previous = key;
+    }
+
+    //a heavy member doesn't take its turns in a row, even across rounds
+    DLR<std::string, int> heavy;
+    heavy.pushBack("a", 5);
+    heavy.pushBack("b", 1);
+    heavy.pushBack("c", 1);
+    RoundRobin<std::string, int> smooth(heavy);
+    CHECK(smooth.roundLength() == 7);
+    unsigned int run = 0, longest = 0;
+    for(int i = 0; i < 70; i++){
+        CHECK(smooth.next(key, info));
+        run = key == "a" ? run + 1 : 0;
+        longest = std::max(longest, run);
+    }
+    CHECK(longest <= 3);
+
+    //weights from a function, divided by their greatest common divisor
+    RoundRobin<std::string, int> flat(ring, [](const int &){ return 2u; });
+    CHECK(flat.roundLength() == 5);
+
+    //a long round is scaled down, but keeps every member
+    DLR<std::string, int> skewed;
+    skewed.pushBack("huge", 1000000);
+    skewed.pushBack("tiny", 1);
+    RoundRobin<std::string, int> scaled(skewed);
+    CHECK(scaled.roundLength() <= 4097);
+    auto counts = picks(scaled, scaled.roundLength());
+    CHECK(counts["tiny"] == 1 && counts["huge"] + 1 == scaled.roundLength());
+
+    //nothing to pick
+    DLR<std::string, int> empty;
+    RoundRobin<std::string, int> none(empty);
+    CHECK(!none.next(key, info));
+    CHECK(none.roundLength() == 0);
+
+}
+
+
+static void health(){
+
+    DLR<std::string, int> ring;
+    ring.pushBack("a", 1);
+    ring.pushBack("b", 2);
+    ring.pushBack("c", 3);
+    RoundRobin<std::string, int> scheduler(ring);
+
+    CHECK(scheduler.markDown("c"));
+    CHECK(!scheduler.markDown("unknown"));
+    CHECK(!scheduler.isUp("c") && scheduler.isUp("a"));
+    //turns of members down stay in the round, next() moves past them
+    CHECK(scheduler.roundLength() == 6);
+    auto counts = picks(scheduler, 30);
+    CHECK(counts["c"] == 0 && counts["a"] > 0 && counts["b"] > counts["a"]);
+
+    //reload keeps the state of members which stay, new ones are up
+    ring.pushBack("d", 1);
+    scheduler.reload(ring);
+    CHECK(!scheduler.isUp("c") && scheduler.isUp("d"));
+    CHECK(scheduler.roundLength() == 7);
+
+    CHECK(scheduler.markUp("c"));
+    CHECK(scheduler.markUp("c"));
+    counts = picks(scheduler, 70);
+    CHECK(counts["a"] == 10 && counts["b"] == 20 && counts["c"] == 30 && counts["d"] == 10);
+
+    scheduler.markDown("a");
+    scheduler.markDown("b");
+    scheduler.markDown("c");
+    scheduler.markDown("d");
+    std::string key = "unchanged";
+    int info = -1;
+    CHECK(!scheduler.next(key, info));
+    CHECK(key == "unchanged" && info == -1);
+
+    //members of weight 0 coming up don't make anything pickable
+    DLR<std::string, int> idle;
+    idle.pushBack("idle", 0);
+    RoundRobin<std::string, int> nothing(idle);
+    CHECK(nothing.markDown("idle") && nothing.markUp("idle"));
+    CHECK(!nothing.next(key, info));
+
+}
+
+
+static void concurrentPicks(){
+
+    DLR<std::string, int> ring;
+    for(int i = 0; i < 20; i++)
+        ring.pushBack("member" + std::to_string(i), 1 + i % 5);
+    ring.pushBack("down", 1000);
+    RoundRobin<std::string, int> scheduler(ring);
+    scheduler.markDown("down");
+
+    std::atomic<bool> done(false);
+    std::atomic<unsigned long long> picked(0);
+    std::vector<std::thread> readers;
+    for(int t = 0; t < 6; t++){
+        readers.emplace_back([&]{
+            std::string key;
+            int info;
+            while(!done){
+                if(scheduler.next(key, info)){
+                    CHECK(key != "down");
+                    CHECK(key.compare(0, 6, "member") == 0 || key.compare(0, 5, "extra") == 0);
+                    picked++;
+                }
+            }
+        });
+    }
+
+    //the writer changes health and membership meanwhile
+    for(int i = 0; i < 300; i++){
+        auto name = "member" + std::to_string(i % 20);
+        scheduler.markDown(name);
+        scheduler.markUp(name);
+        if(i % 10 == 0){
+            ring.pushBack("extra" + std::to_string(i), 1 + i % 3);
+            scheduler.reload(ring);
+        }
+    }
+    done = true;
+    for(auto &reader : readers)
+        reader.join();
+
+    CHECK(picked > 0);
+    CHECK(!scheduler.isUp("down"));
+    CHECK(scheduler.size() == ring.length());
+
+}
+
+
+int main(){
+
+    weights();
+    health();
+    concurrentPicks();
+
+    return 0;
+
+}
@@ -0,0 +1,104 @@
+//
+// Created by Ernest Pokropek
+//
+
+
+/***************************************************************************
+* Tests of ShardedDLR used by many threads at once. Meant to be run with
+* the thread sanitizer.
+****************************************************************************/
+
+#include <map>
+#include <thread>
+
+#include "ShardedDLR.h"
+#include "TestUtil.h"
+
+
+static void concurrentModifiers(){
+
+    const int threads = 8, pushes = 5000, keys = 63;
+    ShardedDLR<int, int> sharded(4);
+
+    std::vector<std::thread> workers;
+    for(int t = 0; t < threads; t++){
+        workers.emplace_back([&sharded, t]{
+            for(int i = 0; i < pushes; i++){
+                sharded.pushBack(i % keys, t);
+                //every thread removes a quarter of what it added
+                if(i % 4 == 3)
+                    CHECK(sharded.remove(i % keys));
+                if(i % 100 == 0)
+                    sharded.exists(i % keys);
+            }
+        });
+    }
+    //a reader going through the whole container meanwhile
+    workers.emplace_back([&sharded]{
+        for(int i = 0; i < 50; i++){
+            unsigned int visited = 0;
+            sharded.forEach([&visited](const int &, int &){ visited++; });
+            sharded.length();
+        }
+    });
+    for(auto &worker : workers)
+        worker.join();
+
+    CHECK(sharded.length() == threads * pushes * 3 / 4);
+
+    std::map<int, unsigned int> counts;
+    sharded.forEach([&counts](const int &key, int &){ counts[key]++; });
+    CHECK(counts.size() == static_cast<unsigned int>(keys));
+    for(auto &count : counts)
+        CHECK(sharded.howMany(count.first) == count.second);
+
+    sharded.clear();
+    CHECK(sharded.isEmpty());
+
+}
+
+
+static void occurrences(){
+
+    //all nodes of a key are in one shard, so occurrences count like in a DLR
+    ShardedDLR<int, int> sharded(8);
+    for(int i = 0; i < 10; i++)
+        sharded.pushBack(7, i);
+    CHECK(sharded.remove(7, 3));
+    CHECK(!sharded.remove(7, 10));
+    CHECK(!sharded.remove(8));
+
+    std::vector<int> infos;
+    sharded.forEach([&infos](const int &, int &info){ infos.push_back(info); });
+    //like in a DLR, 'any' moves to the element after the removed one
+    CHECK((infos == std::vector<int>{3, 4, 5, 6, 7, 8, 9, 0, 1}));
+
+}
+
+
+static void shards(){
+
+    ShardedDLR<int, int> sharded(8);
+    for(int i = 0; i < 8000; i += 8)
+        sharded.pushBack(i, i);
+    CHECK(sharded.length() == 1000);
+    CHECK(sharded.shardCount() == 8);
+
+    ShardedDLR<int, int> single(0);
+    CHECK(single.shardCount() == 1);
+
+    ShardedDLR<int, int> defaulted;
+    CHECK(defaulted.shardCount() >= 1);
+
+}
+
+
+int main(){
+
+    concurrentModifiers();
+    occurrences();
+    shards();
+
+    return 0;
+
+}
@@ -0,0 +1,87 @@
+//
+// Created by Ernest Pokropek
+//
+
+
+/***************************************************************************
+* Tests of blocks of nodes shared by DLRs used from different threads:
+* a DLR is split in two, and both halves are drained at the same time, so
+* the last node of a block may go away in either thread. Meant to be run
+* with the thread sanitizer.
+****************************************************************************/
+
+#include <thread>
+
+#include "TestUtil.h"
+
+
+// removes every element of the DLR, from a random place each time
+static void drain(DLR<int, int> &ring, unsigned int seed){
+
+    while(!ring.isEmpty()){
+        seed = seed * 1103515245 + 12345;
+        ring.remove(ring.begin() + (seed >> 16) % 8);
+    }
+
+}
+
+
+static void splitAndDrain(bool compacted){
+
+    for(int round = 0; round < 50; round++){
+        Model model;
+        for(int i = 0; i < 2000; i++)
+            model.push_back(std::make_pair(i, round));
+
+        //nodes in blocks, also several blocks sharing each half
+        DLR<int, int> first;
+        first.pushBack(Model(model.begin(), model.begin() + 1000));
+        first.pushBack(Model(model.begin() + 1000, model.end()));
+        if(compacted)
+            first.compact();
+
+        DLR<int, int> second;
+        first.split(first.begin() + randomIn(1, 1999), second);
+        CHECK(first.length() + second.length() == 2000);
+
+        std::thread other(drain, std::ref(second), 7u + round);
+        drain(first, 11u + round);
+        other.join();
+
+        CHECK(first.isEmpty() && second.isEmpty());
+    }
+
+}
+
+
+static void interleavedDrain(){
+
+    //neighbouring nodes of a block end up in different DLRs
+    for(int round = 0; round < 20; round++){
+        Model model;
+        for(int i = 0; i < 3000; i++)
+            model.push_back(std::make_pair(i, i));
+
+        DLR<int, int> first;
+        first.pushBack(model);
+        DLR<int, int> second;
+        first.partition([](const int &key, const int &){ return key % 2 == 0; }, second);
+        CHECK(first.length() == 1500 && second.length() == 1500);
+
+        std::thread other(drain, std::ref(second), 3u + round);
+        drain(first, 5u + round);
+        other.join();
+    }
+
+}
+
+
+int main(){
+
+    splitAndDrain(false);
+    splitAndDrain(true);
+    interleavedDrain();
+
+    return 0;
+
+}
@@ -0,0 +1,222 @@
+//
+// Created by Ernest Pokropek
+//
+
+
+/***************************************************************************
+* Helpers shared by the tests. Every test is a program returning 0 when
+* all of its checks pass; a failed check aborts it with the failed
+* condition, also in builds defining NDEBUG.
+*
+* Randomized tests compare a DLR with a model: std::vector of Key and Info
+* pairs, in the order of the DLR starting from 'any'.
+****************************************************************************/
+
+#ifndef EADS2_TESTUTIL_H
+#define EADS2_TESTUTIL_H
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "DLR.h"
+
+#define CHECK(condition) \
+    do{ \
+        if(!(condition)){ \
+            std::fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+            std::abort(); \
+        } \
+    }while(false)
+
+
+// RETURNS: elements of the DLR in their order, starting from 'any'
+template<typename Key, typename Info, unsigned int Inline>
+std::vector<std::pair<Key, Info>> contentOf(const DLR<Key, Info, Inline> &ring){
+
+    std::vector<std::pair<Key, Info>> content;
+    if(ring.length() == 0)
+        return content;
+
+    auto travel = ring.begin();
+    do{
+        auto element = *travel;
+        content.push_back(std::make_pair(element.key, element.info));
+        ++travel;
+    }while(travel != ring.begin());
+
+    return content;
+
+}
+
+
+// RETURNS: DLR holding the elements of the model, in their order
+template<typename Key, typename Info, unsigned int Inline = 0>
+DLR<Key, Info, Inline> ringOf(const std::vector<std::pair<Key, Info>> &model){
+
+    DLR<Key, Info, Inline> ring;
+    for(auto &element : model)
+        ring.pushBack(element.first, element.second);
+    return ring;
+
+}
+
+
+// checks the DLR against the model, its length and, when enabled, its hash
+template<typename Key, typename Info, unsigned int Inline>
+void checkRing(const DLR<Key, Info, Inline> &ring, const std::vector<std::pair<Key, Info>> &model){
+
+    CHECK(ring.length() == model.size());
+    CHECK(contentOf(ring) == model);
+
+    if(ring.hash() != 0){
+        DLR<Key, Info, Inline> fresh(ring);
+        fresh.enableHash();
+        CHECK(fresh.hash() == ring.hash());
+    }
+
+}
+
+
+// random generator of a test, seeded the same for every run
+inline std::mt19937 &generator(){
+    static std::mt19937 seeded(20240531);
+    return seeded;
+}
+
+
+// RETURNS: random integer from the range [from, to]
+inline int randomIn(int from, int to){
+    return std::uniform_int_distribution<int>(from, to)(generator());
+}
+
+
+typedef std::vector<std::pair<int, int>> Model;
+
+
+// RETURNS: number of elements of the model having given key
+inline int howMany(const Model &model, int key){
+
+    int count = 0;
+    for(auto &element : model){
+        if(element.first == key)
+            count++;
+    }
+    return count;
+
+}
+
+
+// RETURNS: number of elements of the model before given index having the same key
+inline int occurrenceAt(const Model &model, unsigned int index){
+
+    int occurrence = 1;
+    for(unsigned int i = 0; i < index; i++){
+        if(model[i].first == model[index].first)
+            occurrence++;
+    }
+    return occurrence;
+
+}
+
+
+// applies random modifications to a DLR and to a model, checking them
+// against each other after every step
+// PARAMETERS: whether the DLR maintains its content hash,
+//             automatic compaction threshold, 0 for none
+template<unsigned int Inline>
+void randomOperations(bool hashed, double autoCompact){
+
+    typedef typename DLR<int, int, Inline>::Iterator Iterator;
+
+    DLR<int, int, Inline> ring;
+    Model model;
+    if(hashed)
+        ring.enableHash();
+    ring.setAutoCompact(autoCompact);
+
+    for(int step = 0; step < 4000; step++){
+        int newKey = randomIn(0, 20);
+        int newInfo = randomIn(-1000, 1000);
+
+        switch(randomIn(0, 9)){
+            case 0:
+            case 1:
+                ring.pushBack(newKey, newInfo);
+                model.push_back(std::make_pair(newKey, newInfo));
+                break;
+
+            case 2:{
+                Model elements;
+                for(int i = randomIn(0, 12); i > 0; i--)
+                    elements.push_back(std::make_pair(randomIn(0, 20), randomIn(-1000, 1000)));
+                ring.pushBack(elements);
+                model.insert(model.end(), elements.begin(), elements.end());
+                break;
+            }
+
+            case 3:
+            case 4:{
+                if(model.empty())
+                    break;
+                unsigned int index = randomIn(0, model.size() - 1);
+                int key = model[index].first;
+                CHECK(ring.insertAfter(key, newKey, newInfo, occurrenceAt(model, index)));
+                model.insert(model.begin() + index + 1, std::make_pair(newKey, newInfo));
+                break;
+            }
+
+            case 5:{
+                if(model.empty())
+                    break;
+                unsigned int index = randomIn(0, model.size() - 1);
+                int key = model[index].first;
+                CHECK(ring.insertBefore(key, newKey, newInfo, occurrenceAt(model, index)));
+                //inserted before 'any' is the same as at the end
+                model.insert(index == 0 ? model.end() : model.begin() + index, std::make_pair(newKey, newInfo));
+                break;
+            }
+
+            case 6:
+            case 7:{
+                if(model.empty())
+                    break;
+                unsigned int index = randomIn(0, model.size() - 1);
+                int key = model[index].first;
+                int occurrence = occurrenceAt(model, index);
+                CHECK(ring.find(key, occurrence) != Iterator());
+                CHECK(ring.remove(key, occurrence));
+                //'any' moves to the element after the removed one
+                model.erase(model.begin() + index);
+                if(!model.empty())
+                    std::rotate(model.begin(), model.begin() + index % model.size(), model.end());
+                break;
+            }
+
+            case 8:
+                ring.compact();
+                if(Inline == 0)
+                    CHECK(ring.fragmentation() == 0);
+                break;
+
+            case 9:
+                CHECK(!ring.remove(Iterator()));
+                CHECK(ring.find(newKey, howMany(model, newKey) + 1) == Iterator());
+                CHECK(ring.howMany(newKey) == static_cast<unsigned int>(howMany(model, newKey)));
+                if(randomIn(0, 20) == 0 && !model.empty()){
+                    ring.clear();
+                    model.clear();
+                }
+                break;
+        }
+
+        checkRing(ring, model);
+    }
+
+}
+
+
+#endif //EADS2_TESTUTIL_H